@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+
+# Runs yer-face over the same footage once per face detection method and compares
+# detection latency, recall, and CPU usage. Recall is reported as the fraction of
+# detection passes which found a face, so footage should have a face in every frame.
+#
+# Example:
+#   ci/util/benchmark-face-detectors.py --yerFace=build/yer-face --inVideo=footage.mkv \
+#     --openCVModel=res10_300x300_ssd_iter_140000.caffemodel --openCVConfig=deploy.prototxt
+
+import argparse,json,os,re,resource,subprocess,sys,tempfile,time
+
+SUMMARY_PATTERN = re.compile(r'Detection Summary: <Method: (\S+), Detections: (\d+), With Face: (\d+) \(([\d.]+)%\), Passes: (\d+), Average Pass: ([\d.]+)ms, Worst Pass: ([\d.]+)ms>')
+
+parser = argparse.ArgumentParser(description='Compare yer-face face detection methods on the same footage.')
+parser.add_argument('--yerFace', default='yer-face', help='Path to the yer-face executable.')
+parser.add_argument('--configFile', default='data/yer-face-config.json', help='Base configuration file.')
+parser.add_argument('--inVideo', required=True, help='Footage to benchmark against.')
+parser.add_argument('--methods', default='dlibHOG,dlibMMOD,openCVDNN', help='Comma separated list of detection methods.')
+parser.add_argument('--openCVModel', default='', help='Model file for the openCVDNN method.')
+parser.add_argument('--openCVConfig', default='', help='Network configuration file for the openCVDNN method.')
+parser.add_argument('--lowLatency', action='store_true', help='Benchmark in low latency mode.')
+args = parser.parse_args()
+
+with open(args.configFile) as f:
+	baseConfig = json.load(f)
+
+results = []
+for method in args.methods.split(','):
+	config = json.loads(json.dumps(baseConfig))
+	config['YerFace']['FaceDetector']['detectionMethod'] = method
+	if method == 'openCVDNN':
+		if len(args.openCVModel) < 1:
+			print('Skipping openCVDNN because no --openCVModel was specified.', file=sys.stderr)
+			continue
+		config['YerFace']['FaceDetector']['openCVDNN']['model'] = os.path.abspath(args.openCVModel)
+		config['YerFace']['FaceDetector']['openCVDNN']['config'] = os.path.abspath(args.openCVConfig) if len(args.openCVConfig) > 0 else ''
+
+	with tempfile.NamedTemporaryFile(mode='w', suffix='.json', delete=False) as configFile:
+		json.dump(config, configFile, indent=2)
+	command = [args.yerFace, '--headless', '--configFile=' + configFile.name, '--inVideo=' + args.inVideo]
+	if args.lowLatency:
+		command.append('--lowLatency')
+
+	usageBefore = resource.getrusage(resource.RUSAGE_CHILDREN)
+	wallStart = time.time()
+	proc = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+	wallSeconds = time.time() - wallStart
+	usageAfter = resource.getrusage(resource.RUSAGE_CHILDREN)
+	os.unlink(configFile.name)
+
+	cpuSeconds = (usageAfter.ru_utime - usageBefore.ru_utime) + (usageAfter.ru_stime - usageBefore.ru_stime)
+	match = SUMMARY_PATTERN.search(proc.stdout)
+	if proc.returncode != 0 or match is None:
+		print('Method %s failed (exit code %d):\n%s' % (method, proc.returncode, proc.stdout[-2000:]), file=sys.stderr)
+		continue
+	results.append({
+		'method': method,
+		'detections': int(match.group(2)),
+		'recall': float(match.group(4)),
+		'averageMs': float(match.group(6)),
+		'worstMs': float(match.group(7)),
+		'wallSeconds': wallSeconds,
+		'cpuSeconds': cpuSeconds,
+		'cpuUtilization': cpuSeconds / wallSeconds if wallSeconds > 0.0 else 0.0
+	})
+
+print('%-12s %10s %8s %12s %12s %10s %10s %8s' % ('Method', 'Detections', 'Recall', 'Avg Pass', 'Worst Pass', 'Wall', 'CPU', 'Cores'))
+for r in results:
+	print('%-12s %10d %7.1f%% %10.2fms %10.2fms %9.1fs %9.1fs %8.2f' % (r['method'], r['detections'], r['recall'], r['averageMs'], r['worstMs'], r['wallSeconds'], r['cpuSeconds'], r['cpuUtilization']))
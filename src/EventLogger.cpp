@@ -69,12 +69,20 @@ EventLogger::EventLogger(json config, string myEventFile, double myEventFileStar
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	logger->debug1("EventLogger object constructed and ready to go!");
 }
 
 EventLogger::~EventLogger() noexcept(false) {
 	logger->debug1("EventLogger object destructing...");
 
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	if(replayWorkerPool) {
 		delete replayWorkerPool;
 	}
@@ -187,6 +195,16 @@ void EventLogger::processNextPacket(FrameTimestamps frameTimestamps) {
 	}
 }
 
+void EventLogger::handleFrameServerStallEvent(void *userdata) {
+	EventLogger *self = (EventLogger *)userdata;
+	YerFace_MutexLock(self->myMutex);
+	size_t frameEventsDepth = self->frameEvents.size();
+	size_t replayDepth = self->pendingReplayFrames.size();
+	bool myEventReplayHold = self->eventReplayHold;
+	YerFace_MutexUnlock(self->myMutex);
+	self->logger->warning("... Queue depths: <Frame Events: %lu, Pending Replay Frames: %lu> Event Replay Hold: %s", frameEventsDepth, replayDepth, myEventReplayHold ? "TRUE" : "FALSE");
+}
+
 void EventLogger::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	EventLogger *self = (EventLogger *)userdata;
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
@@ -263,7 +281,7 @@ bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 
 		self->eventReplayHold = false;
 
-		self->logger->debug4("EVENT REPLAY: Playing up to frame #" YERFACE_FRAMENUMBER_FORMAT " at time: %lf-%lf", frameTimestamps.frameNumber, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
+		YerFace_LogDebug4(self->logger, "EVENT REPLAY: Playing up to frame #" YERFACE_FRAMENUMBER_FORMAT " at time: %lf-%lf", frameTimestamps.frameNumber, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
 
 		YerFace_MutexLock(self->myMutex);
 		self->processNextPacket(frameTimestamps);
@@ -273,11 +291,11 @@ bool EventLogger::replayWorkerHandler(WorkerPoolWorker *worker) {
 			self->processNextPacket(frameTimestamps);
 		}
 		if(self->eventReplayHold) {
-			self->logger->debug4("HOLDING...");
+			YerFace_LogDebug4(self->logger, "HOLDING...");
 		}
 		YerFace_MutexUnlock(self->myMutex);
 
-		self->logger->debug4("DONE EVENT REPLAY: Finished frame #" YERFACE_FRAMENUMBER_FORMAT " at time: %lf-%lf", frameTimestamps.frameNumber, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
+		YerFace_LogDebug4(self->logger, "DONE EVENT REPLAY: Finished frame #" YERFACE_FRAMENUMBER_FORMAT " at time: %lf-%lf", frameTimestamps.frameNumber, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
 
 		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_PREPROCESS, "eventLogger.ran");
 
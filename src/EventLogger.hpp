@@ -36,6 +36,7 @@ public:
 private:
 	void processNextPacket(FrameTimestamps frameTimestamps);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static bool replayWorkerHandler(WorkerPoolWorker *worker);
 	string eventFilename;
 	double eventFileStartSeconds;
@@ -47,9 +47,10 @@ MediaOutputContext::MediaOutputContext(void) {
 	initialized = false;
 }
 
-FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions) {
+FFmpegDriver::FFmpegDriver(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions) {
 	videoCaptureWorkerPool = NULL;
 	logger = new Logger("FFmpegDriver");
+	scalingMetrics = new Metrics(config, "FFmpegDriver.Scaling");
 
 	status = myStatus;
 	if(status == NULL) {
@@ -67,6 +68,9 @@ FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool my
 	newestAudioFrameTimestamp = -1.0;
 	newestAudioFrameEstimatedEndTimestamp = 0.0;
 	audioFrameHandlersOkay = true;
+	videoFramesDropped = 0;
+	videoFrameBackingsGauge = new MemoryGauge("FFmpegDriver.VideoFrameBackings");
+	audioFrameBackingsGauge = new MemoryGauge("FFmpegDriver.AudioFrameBackings");
 
 	av_log_set_callback(FFmpegDriver::logAVCallback);
 	avdevice_register_all();
@@ -97,6 +101,12 @@ FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool my
 	}
 	audioInContext.frameNumber = 0;
 
+	//If the frame server detects a stall, we want to report on our buffers.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	if(myListAllAvailableOptions) {
 		AVFormatContext *fmt;
 		if((fmt = avformat_alloc_context()) == NULL) {
@@ -111,6 +121,9 @@ FFmpegDriver::FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool my
 
 FFmpegDriver::~FFmpegDriver() noexcept(false) {
 	logger->debug1("FFmpegDriver object destructing...");
+
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	destroyDemuxerThread(&videoInContext);
 	destroyDemuxerThread(&audioInContext);
 	destroyMuxerThread();
@@ -141,13 +154,14 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 		// logger->debug3("Calling av_frame_free(&%s->frame)", contextName.c_str());
 		av_frame_free(&inputContext->frame);
 	}
-	logger->debug3("Calling av_free(videoDestData[0])");
+	YerFace_LogDebug3(logger, "Calling av_free(videoDestData[0])");
 	av_free(videoDestData[0]);
 	for(VideoFrameBacking *backing : allocatedVideoFrameBackings) {
 		// logger->debug3("Calling av_frame_free(&backing->frameBGR)");
 		av_frame_free(&backing->frameBGR);
 		// logger->debug3("Calling av_free(backing->buffer)");
 		av_free(backing->buffer);
+		videoFrameBackingsGauge->released(backing->bufferSize);
 		delete backing;
 	}
 	for(AudioFrameHandler *handler : audioFrameHandlers) {
@@ -157,6 +171,7 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 			av_freep(&nextFrame.bufferArray[0]);
 			// logger->debug3("Calling av_freep(&nextFrame.bufferArray)");
 			av_freep(&nextFrame.bufferArray);
+			audioFrameBackingsGauge->released(nextFrame.bufferSize);
 			handler->resampler.audioFrameBackings.pop_back();
 		}
 		if(handler->resampler.swrContext != NULL) {
@@ -167,6 +182,9 @@ FFmpegDriver::~FFmpegDriver() noexcept(false) {
 	}
 	// logger->debug3("Calling sws_freeContext(swsContext)");
 	sws_freeContext(swsContext);
+	delete videoFrameBackingsGauge;
+	delete audioFrameBackingsGauge;
+	delete scalingMetrics;
 	delete logger;
 
 	//This helps force the AV logs to flush. (Note the \n at the end of the line.)
@@ -462,7 +480,7 @@ bool FFmpegDriver::getIsVideoFrameBufferEmpty(void) {
 VideoFrame FFmpegDriver::getNextVideoFrame(void) {
 	YerFace_MutexLock(videoFrameBufferMutex);
 	VideoFrame result;
-	logger->debug4("getNextVideoFrame() current readyVideoFrameBuffer.size() is %lu", readyVideoFrameBuffer.size());
+	YerFace_LogDebug4(logger, "getNextVideoFrame() current readyVideoFrameBuffer.size() is %lu", readyVideoFrameBuffer.size());
 	if(readyVideoFrameBuffer.size() > 0) {
 		result = readyVideoFrameBuffer.back();
 		readyVideoFrameBuffer.pop_back();
@@ -522,6 +540,27 @@ void FFmpegDriver::logAVErr(string msg, int err) {
 	logger->err("%s AVERROR: (%d) %s", msg.c_str(), err, errbuf);
 }
 
+void FFmpegDriver::handleFrameServerStallEvent(void *userdata) {
+	FFmpegDriver *self = (FFmpegDriver *)userdata;
+	YerFace_MutexLock(self->videoFrameBufferMutex);
+	size_t readyDepth = self->readyVideoFrameBuffer.size();
+	size_t backingsInUse = 0;
+	for(VideoFrameBacking *backing : self->allocatedVideoFrameBackings) {
+		if(backing->inUse) {
+			backingsInUse++;
+		}
+	}
+	size_t backingsTotal = self->allocatedVideoFrameBackings.size();
+	YerFace_MutexUnlock(self->videoFrameBufferMutex);
+	YerFace_MutexLock(self->audioFrameHandlersMutex);
+	string audioDepths = "";
+	for(AudioFrameHandler *handler : self->audioFrameHandlers) {
+		audioDepths += (audioDepths.length() > 0 ? ", " : "") + to_string(handler->resampler.audioFrameBackings.size()) + (handler->drained ? " (drained)" : "");
+	}
+	YerFace_MutexUnlock(self->audioFrameHandlersMutex);
+	self->logger->warning("... Queue depths: <Ready Video Frames: %lu, Video Frame Backings In Use: %lu of %lu, Audio Handler Frames: [%s]>", readyDepth, backingsInUse, backingsTotal, audioDepths.c_str());
+}
+
 VideoFrameBacking *FFmpegDriver::getNextAvailableVideoFrameBacking(void) {
 	YerFace_MutexLock(videoFrameBufferMutex);
 	VideoFrameBacking *myBacking = NULL;
@@ -535,7 +574,7 @@ VideoFrameBacking *FFmpegDriver::getNextAvailableVideoFrameBacking(void) {
 			}
 		}
 	}
-	logger->debug4("getNextAvailableVideoFrameBacking() total backings: %lu, available backings: %u", allocatedVideoFrameBackings.size(), availableBackings);
+	YerFace_LogDebug4(logger, "getNextAvailableVideoFrameBacking() total backings: %lu, available backings: %u", allocatedVideoFrameBackings.size(), availableBackings);
 	if(myBacking == NULL) {
 		logger->notice("Out of spare frames in the video frame buffer! Allocating a new one.");
 		myBacking = allocateNewVideoFrameBacking();
@@ -555,6 +594,8 @@ VideoFrameBacking *FFmpegDriver::allocateNewVideoFrameBacking(void) {
 	if((backing->buffer = (uint8_t *)av_malloc(bufferSize*sizeof(uint8_t))) == NULL) {
 		throw runtime_error("failed allocating buffer for backing video frame");
 	}
+	backing->bufferSize = bufferSize;
+	videoFrameBackingsGauge->allocated(bufferSize);
 	if(av_image_fill_arrays(backing->frameBGR->data, backing->frameBGR->linesize, backing->buffer, pixelFormatBacking, width, height, 1) < 0) {
 		throw runtime_error("failed assigning buffer for backing video frame");
 	}
@@ -569,7 +610,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 	int ret;
 
 	if(inputContext->videoStream != NULL && streamIndex == inputContext->videoStreamIndex) {
-		logger->debug3("Got video %s. Sending to codec...", drain ? "flush call" : "packet");
+		YerFace_LogDebug3(logger, "Got video %s. Sending to codec...", drain ? "flush call" : "packet");
 		if(avcodec_send_packet(inputContext->videoDecoderContext, drain ? NULL : inputContext->packet) < 0) {
 			logger->err("Error decoding video frame");
 			return false;
@@ -594,9 +635,11 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 			newestVideoFrameTimestamp = videoFrame.timestamp.startTimestamp;
 			newestVideoFrameEstimatedEndTimestamp = videoFrame.timestamp.estimatedEndTimestamp;
 			YerFace_MutexUnlock(videoStreamMutex);
-			logger->debug4("Inserted a VideoFrame with timestamps: %.04lf - (estimated) %.04lf", videoFrame.timestamp.startTimestamp, videoFrame.timestamp.estimatedEndTimestamp);
+			YerFace_LogDebug4(logger, "Inserted a VideoFrame with timestamps: %.04lf - (estimated) %.04lf", videoFrame.timestamp.startTimestamp, videoFrame.timestamp.estimatedEndTimestamp);
 
+			MetricsTick tick = scalingMetrics->startClock();
 			sws_scale(swsContext, inputContext->frame->data, inputContext->frame->linesize, 0, height, videoFrame.frameBacking->frameBGR->data, videoFrame.frameBacking->frameBGR->linesize);
+			scalingMetrics->endClock(tick);
 			videoFrame.frameCV = Mat(height, width, CV_8UC3, videoFrame.frameBacking->frameBGR->data[0]);
 
 			YerFace_MutexLock(videoFrameBufferMutex);
@@ -608,6 +651,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 					dropCount++;
 				}
 				if(dropCount) {
+					videoFramesDropped += dropCount;
 					logger->info("Dropped %d frame(s)!", dropCount);
 				}
 			}
@@ -618,7 +662,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 		}
 	}
 	if(inputContext->audioStream != NULL && streamIndex == inputContext->audioStreamIndex) {
-		logger->debug3("Got audio %s. Sending to codec...", drain ? "flush call" : "packet");
+		YerFace_LogDebug3(logger, "Got audio %s. Sending to codec...", drain ? "flush call" : "packet");
 		if((ret = avcodec_send_packet(inputContext->audioDecoderContext, drain ? NULL : inputContext->packet)) < 0) {
 			logAVErr("Sending packet to audio codec.", ret);
 			return false;
@@ -678,9 +722,10 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 				//bufferSamples represents the expected number of samples produced by swr_convert() *PER CHANNEL*
 				audioFrameBacking.bufferSamples = (int)av_rescale_rnd(swr_get_delay(handler->resampler.swrContext, inputContext->audioStream->codecpar->sample_rate) + inputContext->frame->nb_samples, handler->audioFrameCallback.sampleRate, inputContext->audioStream->codecpar->sample_rate, AV_ROUND_UP);
 
-				if(av_samples_alloc_array_and_samples(&audioFrameBacking.bufferArray, &bufferLineSize, handler->resampler.numChannels, audioFrameBacking.bufferSamples, handler->audioFrameCallback.sampleFormat, 1) < 0) {
+				if((audioFrameBacking.bufferSize = av_samples_alloc_array_and_samples(&audioFrameBacking.bufferArray, &bufferLineSize, handler->resampler.numChannels, audioFrameBacking.bufferSamples, handler->audioFrameCallback.sampleFormat, 1)) < 0) {
 					throw runtime_error("Failed allocating audio buffer!");
 				}
+				audioFrameBackingsGauge->allocated(audioFrameBacking.bufferSize);
 
 				if((audioFrameBacking.audioSamples = swr_convert(handler->resampler.swrContext, audioFrameBacking.bufferArray, audioFrameBacking.bufferSamples, (const uint8_t **)inputContext->frame->data, inputContext->frame->nb_samples)) < 0) {
 					throw runtime_error("Failed running swr_convert() for audio resampling");
@@ -689,7 +734,7 @@ bool FFmpegDriver::decodePacket(MediaInputContext *inputContext, int streamIndex
 				audioFrameBacking.audioBytes = audioFrameBacking.audioSamples * handler->resampler.numChannels * av_get_bytes_per_sample(handler->audioFrameCallback.sampleFormat);
 				
 				handler->resampler.audioFrameBackings.push_front(audioFrameBacking);
-				logger->debug3("Pushed a resampled audio frame for handler. Frame queue depth is %lu", handler->resampler.audioFrameBackings.size());
+				YerFace_LogDebug3(logger, "Pushed a resampled audio frame for handler. Frame queue depth is %lu", handler->resampler.audioFrameBackings.size());
 			}
 			YerFace_MutexUnlock(audioFrameHandlersMutex);
 
@@ -1057,7 +1102,7 @@ void FFmpegDriver::pumpDemuxer(MediaInputContext *inputContext, enum AVMediaType
 				}
 				if(in != NULL && out != NULL) {
 					inputContext->packet->stream_index = outputStreamIndex;
-					logger->debug4("INPUT %s PACKET: [ time_base: %d / %d, pts: %ld, dts: %ld, duration: %ld ]", inputContext->packet->stream_index == inputContext->videoStreamIndex ? "VIDEO" : "AUDIO", in->time_base.num, in->time_base.den, inputContext->packet->pts, inputContext->packet->dts, inputContext->packet->duration);
+					YerFace_LogDebug4(logger, "INPUT %s PACKET: [ time_base: %d / %d, pts: %ld, dts: %ld, duration: %ld ]", inputContext->packet->stream_index == inputContext->videoStreamIndex ? "VIDEO" : "AUDIO", in->time_base.num, in->time_base.den, inputContext->packet->pts, inputContext->packet->dts, inputContext->packet->duration);
 					inputContext->packet->pts = av_rescale_q_rnd(
 						applyPTSOffset(inputContext->packet->pts, *ptsOffset),
 						in->time_base,
@@ -1070,7 +1115,7 @@ void FFmpegDriver::pumpDemuxer(MediaInputContext *inputContext, enum AVMediaType
 						(AVRounding)(AV_ROUND_NEAR_INF|AV_ROUND_PASS_MINMAX));
 					inputContext->packet->duration = av_rescale_q(inputContext->packet->duration, in->time_base, out->time_base);
 					inputContext->packet->pos = -1;
-					logger->debug4("OUTPUT %s PACKET: [ time_base: %d / %d, pts: %ld, dts: %ld, duration: %ld ]", inputContext->packet->stream_index == inputContext->videoStreamIndex ? "VIDEO" : "AUDIO", out->time_base.num, out->time_base.den, inputContext->packet->pts, inputContext->packet->dts, inputContext->packet->duration);
+					YerFace_LogDebug4(logger, "OUTPUT %s PACKET: [ time_base: %d / %d, pts: %ld, dts: %ld, duration: %ld ]", inputContext->packet->stream_index == inputContext->videoStreamIndex ? "VIDEO" : "AUDIO", out->time_base.num, out->time_base.den, inputContext->packet->pts, inputContext->packet->dts, inputContext->packet->duration);
 					if(inputContext->packet->pts <= *lastPTS || inputContext->packet->dts <= *lastDTS) {
 						logger->crit("Trying to multiplex output media, but %s packet appeared out of order or with bad timestamps! PACKET LOST!", inputContext->packet->stream_index == inputContext->videoStreamIndex ? "VIDEO" : "AUDIO");
 					} else {
@@ -1119,9 +1164,10 @@ bool FFmpegDriver::flushAudioHandlers(bool draining) {
 				}
 				av_freep(&nextFrame.bufferArray[0]);
 				av_freep(&nextFrame.bufferArray);
+				audioFrameBackingsGauge->released(nextFrame.bufferSize);
 				handler->resampler.audioFrameBackings.pop_back();
 			} else {
-				logger->debug3("======== HOLDING AUDIO FRAME FOR LATER");
+				YerFace_LogDebug3(logger, "======== HOLDING AUDIO FRAME FOR LATER");
 				completelyFlushed = false;
 				break;
 			}
@@ -1135,6 +1181,13 @@ bool FFmpegDriver::getIsAudioInputPresent(void) {
 	return (videoInContext.audioStream != NULL) || (audioInContext.audioStream != NULL);
 }
 
+uint64_t FFmpegDriver::getVideoFramesDroppedCount(void) {
+	YerFace_MutexLock(videoFrameBufferMutex);
+	uint64_t count = videoFramesDropped;
+	YerFace_MutexUnlock(videoFrameBufferMutex);
+	return count;
+}
+
 bool FFmpegDriver::getIsAudioDraining(void) {
 	//// WARNING! Do *NOT* call this function with either videoStreamMutex or audioStreamMutex locked!
 	if(!status->getIsRunning()) {
@@ -1183,7 +1236,7 @@ FrameTimestamps FFmpegDriver::resolveFrameTimestamp(MediaInputContext *inputCont
 		estimatedDuration = 0.001;
 	}
 	timestamps.estimatedEndTimestamp = timestamps.startTimestamp + estimatedDuration;
-	logger->debug3("%s Frame Timestamps: startTimestamp %.04lf, estimatedEndTimestamp: %.04lf (original pts: %ld, ptsOffset: %ld, correctedPTS: %ld)", type == AVMEDIA_TYPE_VIDEO ? "VIDEO" : "AUDIO", timestamps.startTimestamp, timestamps.estimatedEndTimestamp, inputContext->frame->pts, *ptsOffset, correctedPTS);
+	YerFace_LogDebug3(logger, "%s Frame Timestamps: startTimestamp %.04lf, estimatedEndTimestamp: %.04lf (original pts: %ld, ptsOffset: %ld, correctedPTS: %ld)", type == AVMEDIA_TYPE_VIDEO ? "VIDEO" : "AUDIO", timestamps.startTimestamp, timestamps.estimatedEndTimestamp, inputContext->frame->pts, *ptsOffset, correctedPTS);
 
 	return timestamps;
 }
@@ -4,6 +4,7 @@
 #include "Utilities.hpp"
 #include "FrameServer.hpp"
 #include "WorkerPool.hpp"
+#include "MemoryGauge.hpp"
 
 #include <string>
 #include <list>
@@ -112,6 +113,7 @@ class VideoFrameBacking {
 public:
 	AVFrame *frameBGR;
 	uint8_t *buffer;
+	int bufferSize;
 	bool inUse;
 };
 
@@ -137,6 +139,7 @@ class AudioFrameBacking {
 public:
 	double timestamp;
 	uint8_t **bufferArray;
+	int bufferSize;
 	int bufferSamples;
 	int audioSamples, audioBytes;
 };
@@ -158,13 +161,14 @@ public:
 
 class FFmpegDriver {
 public:
-	FFmpegDriver(Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions);
+	FFmpegDriver(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency, bool myListAllAvailableOptions);
 	~FFmpegDriver() noexcept(false);
 	void openInputMedia(string inFile, enum AVMediaType type, string inFormat, string inSize, string inChannels, string inRate, string inCodec, string inputAudioChannelMap, bool tryAudio);
 	void openOutputMedia(string outFile);
 	void setVideoCaptureWorkerPool(WorkerPool *workerPool);
 	void rollWorkerThreads(void);
 	bool getIsAudioInputPresent(void);
+	uint64_t getVideoFramesDroppedCount(void);
 	bool getIsVideoFrameBufferEmpty(void);
 	VideoFrame getNextVideoFrame(void);
 	bool pollForNextVideoFrame(VideoFrame *videoFrame);
@@ -191,6 +195,7 @@ private:
 	void recursivelyListAllAVOptions(void *obj, string depth = "-");
 	bool getIsAllocatedVideoFrameBackingsFull(void);
 	int64_t applyPTSOffset(int64_t pts, int64_t offset);
+	static void handleFrameServerStallEvent(void *userdata);
 	static void logAVCallback(void *ptr, int level, const char *fmt, va_list args);
 	static void logAVWrapper(int level, const char *fmt, ...);
 
@@ -209,6 +214,7 @@ private:
 	int width, height;
 	enum AVPixelFormat pixelFormat, pixelFormatBacking;
 	struct SwsContext *swsContext;
+	Metrics *scalingMetrics;
 
 	SDL_mutex *videoStreamMutex;
 	double videoStreamTimeBase;
@@ -227,10 +233,13 @@ private:
 	SDL_mutex *videoFrameBufferMutex;
 	std::list<VideoFrame> readyVideoFrameBuffer;
 	std::list<VideoFrameBacking *> allocatedVideoFrameBackings;
+	uint64_t videoFramesDropped;
+	MemoryGauge *videoFrameBackingsGauge;
 
 	SDL_mutex *audioFrameHandlersMutex;
 	std::vector<AudioFrameHandler *> audioFrameHandlers;
 	bool audioFrameHandlersOkay;
+	MemoryGauge *audioFrameBackingsGauge;
 
 	static Logger *avLogger;
 	static SDL_mutex *avLoggerMutex;
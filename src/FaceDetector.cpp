@@ -8,12 +8,22 @@
 #include "dlib/image_processing/render_face_detections.h"
 #include "dlib/image_processing.h"
 
+#include "opencv2/dnn.hpp"
+
 #include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 
 using namespace std;
 using namespace dlib;
 using namespace cv;
 
+//Approximate size (in pixels) of the smallest face each detector can find, which is the size of its sliding window.
+#define YERFACE_DLIB_HOG_MINIMUM_FACE_PIXELS 80
+#define YERFACE_DLIB_MMOD_MINIMUM_FACE_PIXELS 40
+#define YERFACE_DLIB_HOG_DEFAULT_PYRAMID_LEVELS 1000
+
 namespace YerFace {
 
 template <long num_filters, typename SUBNET> using con5d = dlib::con<num_filters,5,5,2,2,SUBNET>;
@@ -29,10 +39,38 @@ public:
 	FaceDetector *self;
 
 	dlib::frontal_face_detector frontalFaceDetector;
+	//Rebuilding a HOG detector recomputes its filter bank, and ROI searches ask for a new depth almost every frame. So each depth is built once and kept.
+	std::map<unsigned long, dlib::frontal_face_detector> frontalFaceDetectorsByPyramidLevels;
+	dlib::frontal_face_detector *limitedFrontalFaceDetector; //Whichever of the above the next detection should use.
 	FaceDetectionModel faceDetectionModel;
+	cv::dnn::Net openCVNet;
+
+	//The MMOD network only accepts RGB matrices, so we keep these buffers around between detections
+	//and let assign_image() convert into them in place rather than allocating fresh ones each time.
+	dlib::matrix<dlib::rgb_pixel> imageMatrix;
+	std::vector<dlib::matrix<dlib::rgb_pixel>> imageMatrices;
 };
 
-FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer) {
+//Detectors are loaded only once, into this prototype. Each worker gets its own copy, because
+//dlib's detectors keep scratch state from the last detection inside themselves and are not
+//safe to share between threads. Copying in memory is far cheaper than deserializing again.
+//Once every worker has its copy, the prototype is freed.
+class FaceDetectorPrototype {
+public:
+	dlib::frontal_face_detector frontalFaceDetector;
+	FaceDetectionModel faceDetectionModel;
+	std::vector<uchar> openCVModelBuffer, openCVConfigBuffer; //cv::dnn::Net copies are shallow, so for OpenCV we keep the raw model files instead.
+};
+
+static std::vector<uchar> readFileIntoBuffer(string fileName) {
+	ifstream file(fileName, ifstream::in | ifstream::binary);
+	if(file.fail()) {
+		throw runtime_error("Failed opening model file for reading!");
+	}
+	return std::vector<uchar>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency) {
 	detectionWorkerPool = NULL;
 	assignmentWorkerPool = NULL;
 	status = myStatus;
@@ -43,6 +81,7 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	if(frameServer == NULL) {
 		throw invalid_argument("frameServer cannot be NULL");
 	}
+	lowLatency = myLowLatency;
 	logger = new Logger("FaceDetector");
 	if((detectionsMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
@@ -59,21 +98,161 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	if(resultGoodForSeconds < 0.0) {
 		throw invalid_argument("resultGoodForSeconds cannot be less than zero.");
 	}
-	faceDetectionModelFileName = Utilities::fileValidPathOrDie(config["YerFace"]["FaceDetector"]["dlibFaceDetector"]);
 	faceBoxSizeAdjustment = config["YerFace"]["FaceDetector"]["faceBoxSizeAdjustment"];
 	if(faceBoxSizeAdjustment < 0.0) {
 		throw invalid_argument("faceBoxSizeAdjustment cannot be less than zero.");
 	}
+	minimumFaceSize = config["YerFace"]["FaceDetector"]["minimumFaceSize"];
+	if(minimumFaceSize < 0.0 || minimumFaceSize > 1.0) {
+		throw invalid_argument("minimumFaceSize must be between 0.0 and 1.0 inclusive.");
+	}
+	maximumFaceSize = config["YerFace"]["FaceDetector"]["maximumFaceSize"];
+	if(maximumFaceSize <= 0.0 || maximumFaceSize > 1.0) {
+		throw invalid_argument("maximumFaceSize must be greater than 0.0 and no more than 1.0.");
+	}
+	if(minimumFaceSize > maximumFaceSize) {
+		throw invalid_argument("minimumFaceSize cannot be greater than maximumFaceSize.");
+	}
+	maxFaces = config["YerFace"]["FaceDetector"]["maxFaces"];
+	if(maxFaces < 1) {
+		throw invalid_argument("maxFaces cannot be less than one.");
+	}
+	faceAssociationMinimumOverlap = config["YerFace"]["FaceDetector"]["faceAssociationMinimumOverlap"];
+	if(faceAssociationMinimumOverlap <= 0.0 || faceAssociationMinimumOverlap > 1.0) {
+		throw invalid_argument("faceAssociationMinimumOverlap must be greater than 0.0 and no more than 1.0.");
+	}
+	faceForgetAfterSeconds = config["YerFace"]["FaceDetector"]["faceForgetAfterSeconds"];
+	if(faceForgetAfterSeconds < 0.0) {
+		throw invalid_argument("faceForgetAfterSeconds cannot be less than zero.");
+	}
+	nextFaceId = 0;
+	roiSearchEnabled = config["YerFace"]["FaceDetector"]["roiSearchEnabled"];
+	roiSearchBoxScale = config["YerFace"]["FaceDetector"]["roiSearchBoxScale"];
+	if(roiSearchBoxScale < 1.0) {
+		throw invalid_argument("roiSearchBoxScale cannot be less than one.");
+	}
+	roiSearchFullFrameEverySeconds = config["YerFace"]["FaceDetector"]["roiSearchFullFrameEverySeconds"];
+	if(roiSearchFullFrameEverySeconds < 0.0) {
+		throw invalid_argument("roiSearchFullFrameEverySeconds cannot be less than zero.");
+	}
+	lastFullFrameSearchTimestamp = -1.0;
+	adaptiveRedetectionEnabled = config["YerFace"]["FaceDetector"]["adaptiveRedetectionEnabled"];
+	adaptiveRedetectionMaxIntervalSeconds = config["YerFace"]["FaceDetector"]["adaptiveRedetectionMaxIntervalSeconds"];
+	if(adaptiveRedetectionMaxIntervalSeconds < 0.0) {
+		throw invalid_argument("adaptiveRedetectionMaxIntervalSeconds cannot be less than zero.");
+	}
+	adaptiveRedetectionMaxReprojectionError = config["YerFace"]["FaceDetector"]["adaptiveRedetectionMaxReprojectionError"];
+	if(adaptiveRedetectionMaxReprojectionError <= 0.0) {
+		throw invalid_argument("adaptiveRedetectionMaxReprojectionError must be greater than zero.");
+	}
+	adaptiveRedetectionMaxBoxDrift = config["YerFace"]["FaceDetector"]["adaptiveRedetectionMaxBoxDrift"];
+	if(adaptiveRedetectionMaxBoxDrift <= 0.0) {
+		throw invalid_argument("adaptiveRedetectionMaxBoxDrift must be greater than zero.");
+	}
+	redetectionIntervalSeconds = 0.0;
+	lastDetectionRequestedTimestamp = -1.0;
+	offlineBatchSize = config["YerFace"]["FaceDetector"]["offlineBatchSize"];
+	if(offlineBatchSize < 1) {
+		throw invalid_argument("offlineBatchSize cannot be less than one.");
+	}
+	offlineDetectionEveryNFrames = config["YerFace"]["FaceDetector"]["offlineDetectionEveryNFrames"];
+	if(offlineDetectionEveryNFrames < 1) {
+		throw invalid_argument("offlineDetectionEveryNFrames cannot be less than one.");
+	}
+	firstFrameNumber = -1;
 
-	if(faceDetectionModelFileName.length() > 0) {
-		usingDNNFaceDetection = true;
+	if(config["YerFace"]["FaceDetector"].find("detectionMethod") != config["YerFace"]["FaceDetector"].end()) {
+		detectionMethodString = config["YerFace"]["FaceDetector"]["detectionMethod"];
+	} else {
+		//Older configuration files chose the detector by whether a dlib model was given at all.
+		string dlibFaceDetectorRaw = config["YerFace"]["FaceDetector"]["dlibFaceDetector"];
+		detectionMethodString = dlibFaceDetectorRaw.length() > 0 ? "dlibMMOD" : "dlibHOG";
+		logger->notice("FaceDetector detectionMethod is not set. Using %s, based on dlibFaceDetector.", detectionMethodString.c_str());
+	}
+	if(detectionMethodString == "dlibHOG") {
+		detectionMethod = FACE_DETECTION_METHOD_DLIB_HOG;
+	} else if(detectionMethodString == "dlibMMOD") {
+		detectionMethod = FACE_DETECTION_METHOD_DLIB_MMOD;
+		faceDetectionModelFileName = Utilities::fileValidPathOrDie(config["YerFace"]["FaceDetector"]["dlibFaceDetector"]);
+	} else if(detectionMethodString == "openCVDNN") {
+		detectionMethod = FACE_DETECTION_METHOD_OPENCV_DNN;
+		openCVModelFileName = Utilities::fileValidPathOrDie(config["YerFace"]["FaceDetector"]["openCVDNN"]["model"]);
+		string openCVConfigFileNameRaw = config["YerFace"]["FaceDetector"]["openCVDNN"]["config"];
+		if(openCVConfigFileNameRaw.length() > 0) {
+			openCVConfigFileName = Utilities::fileValidPathOrDie(openCVConfigFileNameRaw);
+		}
+		openCVFramework = config["YerFace"]["FaceDetector"]["openCVDNN"]["framework"];
+		openCVInputSize = config["YerFace"]["FaceDetector"]["openCVDNN"]["inputSize"];
+		if(openCVInputSize < 1) {
+			throw invalid_argument("openCVDNN inputSize cannot be less than one.");
+		}
+		json meanValues = config["YerFace"]["FaceDetector"]["openCVDNN"]["mean"];
+		if(!meanValues.is_array() || meanValues.size() != 3) {
+			throw invalid_argument("openCVDNN mean must be an array of three (BGR) values.");
+		}
+		openCVMean = Scalar((double)meanValues[0], (double)meanValues[1], (double)meanValues[2]);
+		openCVConfidenceThreshold = config["YerFace"]["FaceDetector"]["openCVDNN"]["confidenceThreshold"];
+		if(openCVConfidenceThreshold < 0.0 || openCVConfidenceThreshold > 1.0) {
+			throw invalid_argument("openCVDNN confidenceThreshold must be between 0.0 and 1.0 inclusive.");
+		}
 	} else {
-		usingDNNFaceDetection = false;
+		throw invalid_argument("FaceDetector detectionMethod must be one of: dlibHOG, dlibMMOD, openCVDNN");
+	}
+	summaryDetections = 0;
+	summaryDetectionsWithFace = 0;
+	summaryDetectionPasses = 0;
+	summaryDetectionPassSeconds = 0.0;
+	summaryWorstDetectionPassSeconds = 0.0;
+	scheduledDetection = !lowLatency;
+	batchedDetection = scheduledDetection && detectionMethod == FACE_DETECTION_METHOD_DLIB_MMOD && offlineBatchSize > 1;
+
+	//The dlib detectors scan an image pyramid down to the size of their sliding window, so if faces are known to be
+	//large we can shrink the detection frame until the smallest face we care about just fits the window.
+	//OpenCV's SSD models always resize their input to a fixed size, so there is nothing to prune there.
+	detectorMinimumFacePixels = 0;
+	if(detectionMethod == FACE_DETECTION_METHOD_DLIB_HOG) {
+		detectorMinimumFacePixels = YERFACE_DLIB_HOG_MINIMUM_FACE_PIXELS;
+	} else if(detectionMethod == FACE_DETECTION_METHOD_DLIB_MMOD) {
+		detectorMinimumFacePixels = YERFACE_DLIB_MMOD_MINIMUM_FACE_PIXELS;
+	}
+	if(detectorMinimumFacePixels > 0 && minimumFaceSize > 0.0) {
+		frameServer->setDetectionMinimumObjectSize(minimumFaceSize, detectorMinimumFacePixels);
+	}
+	if(scheduledDetection && adaptiveRedetectionEnabled) {
+		//Scheduled detection already runs on a fixed cadence, which keeps offline results reproducible.
+		adaptiveRedetectionEnabled = false;
+	}
+	if(scheduledDetection && roiSearchEnabled) {
+		//Scheduled tasks are queued before the previous detection is known, so there is no region of interest to search.
+		logger->info("Region of interest searching is not used with offline (scheduled) detection.");
+		roiSearchEnabled = false;
+	}
+	if(maxFaces > 1 && roiSearchEnabled) {
+		//A region of interest around one face would hide all of the others.
+		logger->info("Region of interest searching is not used when tracking more than one face.");
+		roiSearchEnabled = false;
 	}
 	latestDetection.run = false;
 	latestDetection.set = false;
 	latestDetectionLostWarning = false;
 
+	prototype = new FaceDetectorPrototype();
+	prototypeCopies = 0;
+	switch(detectionMethod) {
+		case FACE_DETECTION_METHOD_DLIB_HOG:
+			prototype->frontalFaceDetector = get_frontal_face_detector();
+			break;
+		case FACE_DETECTION_METHOD_DLIB_MMOD:
+			deserialize(faceDetectionModelFileName.c_str()) >> prototype->faceDetectionModel;
+			break;
+		case FACE_DETECTION_METHOD_OPENCV_DNN:
+			prototype->openCVModelBuffer = readFileIntoBuffer(openCVModelFileName);
+			if(openCVConfigFileName.length() > 0) {
+				prototype->openCVConfigBuffer = readFileIntoBuffer(openCVConfigFileName);
+			}
+			break;
+	}
+
 	//Hook into the frame lifecycle.
 
 	//We want to know when any frame has entered various statuses.
@@ -87,6 +266,12 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_DETECTION without our blessing.
 	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DETECTION, "faceDetector.ran");
 
@@ -98,7 +283,12 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	workerPoolParameters.deinitializer = NULL;
 	workerPoolParameters.usrPtr = (void *)this;
 	workerPoolParameters.handler = detectionWorkerHandler;
-	detectionWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
+	WorkerPool *newDetectionWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
+	YerFace_MutexLock(myMutex);
+	//Workers may have finished initializing before the pool constructor even returned.
+	detectionWorkerPool = newDetectionWorkerPool;
+	doFreePrototypeIfCopied();
+	YerFace_MutexUnlock(myMutex);
 
 	workerPoolParameters.name = "FaceDetector.Assign";
 	workerPoolParameters.numWorkers = 1;
@@ -109,12 +299,17 @@ FaceDetector::FaceDetector(json config, Status *myStatus, FrameServer *myFrameSe
 	workerPoolParameters.handler = assignmentWorkerHandler;
 	assignmentWorkerPool = new WorkerPool(config, status, frameServer, workerPoolParameters);
 
-	logger->debug1("FaceDetector object constructed with Face Detection Method: %s", usingDNNFaceDetection ? "DNN" : "HOG");
+	logger->debug1("FaceDetector object constructed with Face Detection Method: %s", detectionMethodString.c_str());
+	if(scheduledDetection) {
+		logger->debug1("Running scheduled detection on every %d frame(s), in batches of up to %d frame(s).", offlineDetectionEveryNFrames, batchedDetection ? offlineBatchSize : 1);
+	}
 }
 
 FaceDetector::~FaceDetector() noexcept(false) {
 	logger->debug1("FaceDetector object destructing...");
 
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	delete detectionWorkerPool;
 	delete assignmentWorkerPool;
 
@@ -125,9 +320,18 @@ FaceDetector::~FaceDetector() noexcept(false) {
 		logger->err("Detection Tasks are still pending! Woe is me!");
 	}
 
+	//This summary is intended to make it easy to compare detection methods against each other on the same footage.
+	logger->info("Detection Summary: <Method: %s, Detections: %lu, With Face: %lu (%.01lf%%), Passes: %lu, Average Pass: %.02lfms, Worst Pass: %.02lfms>",
+		detectionMethodString.c_str(), summaryDetections, summaryDetectionsWithFace,
+		summaryDetections > 0 ? 100.0 * (double)summaryDetectionsWithFace / (double)summaryDetections : 0.0,
+		summaryDetectionPasses,
+		summaryDetectionPasses > 0 ? 1000.0 * summaryDetectionPassSeconds / (double)summaryDetectionPasses : 0.0,
+		1000.0 * summaryWorstDetectionPassSeconds);
+
 	SDL_DestroyMutex(myMutex);
 	SDL_DestroyMutex(myAssignmentMutex);
 	SDL_DestroyMutex(detectionsMutex);
+	delete prototype;
 	delete logger;
 	delete assignmentMetrics;
 	delete metrics;
@@ -141,71 +345,245 @@ FacialDetectionBox FaceDetector::getFacialDetection(FrameNumber frameNumber) {
 	return detection;
 }
 
+int FaceDetector::getMaxFaces(void) {
+	return maxFaces;
+}
+
+double FaceDetector::getFaceAssociationMinimumOverlap(void) {
+	return faceAssociationMinimumOverlap;
+}
+
+void FaceDetector::reportTrackedFace(int faceId, Rect2d boxNormalSize, FrameTimestamps frameTimestamps) {
+	//A face the tracker is still following is still here, even if the detector keeps missing it. (For example, a turned head.)
+	//  Keeping its box fresh also lets the next detection of it match its old ID instead of getting a new one.
+	YerFace_MutexLock(detectionsMutex);
+	for(FaceDetectorKnownFace &knownFace : knownFaces) {
+		if(knownFace.face.faceId == faceId && frameTimestamps.startTimestamp > knownFace.lastSeenTimestamp) {
+			knownFace.face.boxNormalSize = boxNormalSize;
+			knownFace.lastSeenTimestamp = frameTimestamps.startTimestamp;
+			break;
+		}
+	}
+	YerFace_MutexUnlock(detectionsMutex);
+}
+
+bool FaceDetector::getTrackingHealthIsGood(FaceTrackingHealth health) {
+	return health.landmarksSet && !health.poseRejected && health.reprojectionError <= adaptiveRedetectionMaxReprojectionError && health.boxDrift <= adaptiveRedetectionMaxBoxDrift;
+}
+
+bool FaceDetector::reportTrackingHealth(FaceTrackingHealth health) {
+	bool healthy = getTrackingHealthIsGood(health);
+	if(!adaptiveRedetectionEnabled) {
+		return healthy;
+	}
+
+	YerFace_MutexLock(myMutex);
+	if(healthy) {
+		//Back off gradually. Each healthy frame adds its own duration to the interval between detections.
+		double frameDuration = health.timestamps.estimatedEndTimestamp - health.timestamps.startTimestamp;
+		redetectionIntervalSeconds = std::min(adaptiveRedetectionMaxIntervalSeconds, redetectionIntervalSeconds + frameDuration);
+	} else {
+		if(redetectionIntervalSeconds > 0.0) {
+			YerFace_LogDebug2(logger, "Tracking degraded on frame #" YERFACE_FRAMENUMBER_FORMAT " <Landmarks: %s, Pose Rejected: %s, Reprojection Error: %.03lf, Box Drift: %.03lf>. Re-detecting immediately.",
+				health.timestamps.frameNumber, health.landmarksSet ? "yes" : "no", health.poseRejected ? "yes" : "no", health.reprojectionError, health.boxDrift);
+		}
+		redetectionIntervalSeconds = 0.0;
+	}
+	YerFace_MutexUnlock(myMutex);
+	return healthy;
+}
+
 void FaceDetector::renderPreviewHUD(Mat previewFrame, FrameNumber frameNumber, int density, bool mirrorMode) {
 	YerFace_MutexLock(detectionsMutex);
 	FacialDetectionBox detection = detections[frameNumber];
 	YerFace_MutexUnlock(detectionsMutex);
 
 	if(density > 1) {
-		if(detection.set) {
-			cv::Rect2d box = detection.boxNormalSize;
+		for(FacialDetectionFace face : detection.faces) {
+			cv::Rect2d box = face.boxNormalSize;
 			if(mirrorMode) {
 				box.x = previewFrame.size().width - box.x - box.width;
 			}
 			cv::rectangle(previewFrame, box, Scalar(255, 255, 0), 1, LINE_AA); // FIXME - proportional drawing
+			if(maxFaces > 1) {
+				cv::putText(previewFrame, std::to_string(face.faceId), box.tl() + Point2d(2.0, 14.0), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(255, 255, 0), 1, LINE_AA); // FIXME - proportional drawing
+			}
 		}
 	}
 }
 
+static Rect2d dlibRectangleToRect2d(dlib::rectangle rect) {
+	return Rect2d(rect.left(), rect.top(), rect.right() - rect.left(), rect.bottom() - rect.top());
+}
+
 void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectionTask task) {
 	FaceDetectorWorker *worker = (FaceDetectorWorker *)workerPoolWorker->ptr;
-	dlib::cv_image<dlib::bgr_pixel> dlibDetectionFrame = cv_image<bgr_pixel>(task.detectionFrame);
-	std::vector<dlib::rectangle> faces;
+	std::vector<Rect2d> faces;
+
+	//Largest face we care about, in the coordinates of the full sized frame. (Zero means no limit.)
+	double maximumFacePixelsNormalSize = 0.0;
+	if(maximumFaceSize < 1.0) {
+		maximumFacePixelsNormalSize = maximumFaceSize * (double)std::min(task.detectionFrame.cols, task.detectionFrame.rows) / task.myDetectionScaleFactor;
+	}
+
+	if(task.searchRegionOfInterest) {
+		faces = doDetectFacesInImage(worker, task.roiFrame, maximumFacePixelsNormalSize * task.roiScaleFactor);
+		if(faces.size() > 0) {
+			doProcessDetectedFaces(workerPoolWorker, task, faces, task.roiOffset, task.roiScaleFactor);
+			return;
+		}
+		YerFace_LogDebug2(logger, "Region of interest search failed on frame #" YERFACE_FRAMENUMBER_FORMAT ". Falling back to a full frame search.", task.myFrameNumber);
+		YerFace_MutexLock(myMutex);
+		if(task.myFrameTimestamps.startTimestamp > lastFullFrameSearchTimestamp) {
+			lastFullFrameSearchTimestamp = task.myFrameTimestamps.startTimestamp;
+		}
+		YerFace_MutexUnlock(myMutex);
+	}
+
+	faces = doDetectFacesInImage(worker, task.detectionFrame, maximumFacePixelsNormalSize * task.myDetectionScaleFactor);
+	doProcessDetectedFaces(workerPoolWorker, task, faces, Point2d(0.0, 0.0), task.myDetectionScaleFactor);
+}
 
-	if(usingDNNFaceDetection) {
+std::vector<Rect2d> FaceDetector::doDetectFacesInImage(FaceDetectorWorker *worker, Mat image, double maximumFacePixels) {
+	//cv_image wraps the Mat's memory without copying it. The caller's reference keeps the memory alive until we return.
+	dlib::cv_image<dlib::bgr_pixel> dlibDetectionFrame = cv_image<bgr_pixel>(image);
+	std::vector<Rect2d> faces;
+
+	if(detectionMethod == FACE_DETECTION_METHOD_DLIB_MMOD) {
 		//Using dlib's CNN-based face detector which can (optimistically) be pushed out to the GPU
-		dlib::matrix<dlib::rgb_pixel> imageMatrix;
-		dlib::assign_image(imageMatrix, dlibDetectionFrame);
-		std::vector<dlib::mmod_rect> detections = worker->faceDetectionModel(imageMatrix);
+		dlib::assign_image(worker->imageMatrix, dlibDetectionFrame);
+		std::vector<dlib::mmod_rect> detections = worker->faceDetectionModel(worker->imageMatrix);
 		for(dlib::mmod_rect detection : detections) {
-			faces.push_back(detection.rect);
+			faces.push_back(dlibRectangleToRect2d(detection.rect));
+		}
+	} else if(detectionMethod == FACE_DETECTION_METHOD_OPENCV_DNN) {
+		//Using an SSD-style network via OpenCV's DNN module. Output is [1, 1, N, 7] where each row is
+		//[batchId, classId, confidence, left, top, right, bottom], with coordinates normalized to the input image.
+		Mat blob = cv::dnn::blobFromImage(image, 1.0, Size(openCVInputSize, openCVInputSize), openCVMean, false, false);
+		worker->openCVNet.setInput(blob);
+		Mat output = worker->openCVNet.forward();
+		Mat detections = Mat(output.size[2], output.size[3], CV_32F, output.ptr<float>());
+		for(int i = 0; i < detections.rows; i++) {
+			if(detections.at<float>(i, 2) < openCVConfidenceThreshold) {
+				continue;
+			}
+			Point2d topLeft = Point2d(detections.at<float>(i, 3) * image.cols, detections.at<float>(i, 4) * image.rows);
+			Point2d bottomRight = Point2d(detections.at<float>(i, 5) * image.cols, detections.at<float>(i, 6) * image.rows);
+			faces.push_back(Rect2d(topLeft, bottomRight));
 		}
 	} else {
 		//Using dlib's built-in HOG face detector instead of a CNN-based detector
-		faces = worker->frontalFaceDetector(dlibDetectionFrame);
+		doLimitHOGPyramidLevels(worker, maximumFacePixels);
+		for(dlib::rectangle face : (*worker->limitedFrontalFaceDetector)(dlibDetectionFrame)) {
+			faces.push_back(dlibRectangleToRect2d(face));
+		}
+	}
+	return faces;
+}
+
+void FaceDetector::doLimitHOGPyramidLevels(FaceDetectorWorker *worker, double maximumFacePixels) {
+	//Pyramid level N finds faces about (6/5)^N times larger than the sliding window. Levels beyond the largest face we care about are wasted work.
+	//(The MMOD network's input pyramid has no such knob, so for MMOD oversized faces are only filtered out afterward.)
+	unsigned long levels = YERFACE_DLIB_HOG_DEFAULT_PYRAMID_LEVELS;
+	if(maximumFacePixels > 0.0) {
+		levels = 2 + (unsigned long)std::max(0.0, ceil(log(maximumFacePixels / (double)YERFACE_DLIB_HOG_MINIMUM_FACE_PIXELS) / log(6.0 / 5.0)));
+	}
+	if(levels == YERFACE_DLIB_HOG_DEFAULT_PYRAMID_LEVELS) {
+		worker->limitedFrontalFaceDetector = &worker->frontalFaceDetector;
+		return;
 	}
+	auto detectorIterator = worker->frontalFaceDetectorsByPyramidLevels.find(levels);
+	if(detectorIterator != worker->frontalFaceDetectorsByPyramidLevels.end()) {
+		worker->limitedFrontalFaceDetector = &detectorIterator->second;
+		return;
+	}
+	//Only the pyramid depth changes, so the worker's own copy of the detector is as good a source as the prototype.
+	dlib::frontal_face_detector::image_scanner_type scanner = worker->frontalFaceDetector.get_scanner();
+	scanner.set_max_pyramid_levels(levels);
+	std::vector<dlib::frontal_face_detector::feature_vector_type> weights;
+	for(unsigned long i = 0; i < worker->frontalFaceDetector.num_detectors(); i++) {
+		weights.push_back(worker->frontalFaceDetector.get_w(i));
+	}
+	worker->limitedFrontalFaceDetector = &worker->frontalFaceDetectorsByPyramidLevels[levels];
+	*worker->limitedFrontalFaceDetector = dlib::frontal_face_detector(scanner, worker->frontalFaceDetector.get_overlap_tester(), weights);
+	YerFace_LogDebug2(logger, "Built a HOG detector limited to %lu pyramid levels for faces up to %.01lf pixels.", levels, maximumFacePixels);
+}
 
-	bool bestFaceSet = false;
-	int bestFaceArea = -1;
+void FaceDetector::doDetectFacesBatched(WorkerPoolWorker *workerPoolWorker, std::vector<FaceDetectionTask> tasks) {
+	FaceDetectorWorker *worker = (FaceDetectorWorker *)workerPoolWorker->ptr;
+
+	//All of the detection frames are the same size, so the whole batch can go through the CNN in a single forward pass.
+	worker->imageMatrices.resize(tasks.size());
+	for(size_t i = 0; i < tasks.size(); i++) {
+		dlib::assign_image(worker->imageMatrices[i], cv_image<bgr_pixel>(tasks[i].detectionFrame));
+	}
+	std::vector<std::vector<dlib::mmod_rect>> batchDetections = worker->faceDetectionModel(worker->imageMatrices, worker->imageMatrices.size());
+
+	for(size_t i = 0; i < tasks.size(); i++) {
+		std::vector<Rect2d> faces;
+		for(dlib::mmod_rect detection : batchDetections[i]) {
+			faces.push_back(dlibRectangleToRect2d(detection.rect));
+		}
+		doProcessDetectedFaces(workerPoolWorker, tasks[i], faces, Point2d(0.0, 0.0), tasks[i].myDetectionScaleFactor);
+	}
+}
+
+void FaceDetector::doProcessDetectedFaces(WorkerPoolWorker *workerPoolWorker, FaceDetectionTask task, std::vector<Rect2d> faces, Point2d searchOffset, double searchScaleFactor) {
+	//Faces are found in the coordinates of whatever image was searched, so bring them back to the full sized frame before comparing them.
 	Size2d detectionFrameSize = task.detectionFrame.size();
-	Rect2d detectionFrameBox = Rect2d(0.0, 0.0, detectionFrameSize.width, detectionFrameSize.height);
-	Rect2d bestFaceBox, bestFaceBoxNormalSize;
-	for(dlib::rectangle face : faces) {
-		if((int)face.area() > bestFaceArea) {
-			bestFaceSet = true;
-			bestFaceArea = face.area();
-			bestFaceBox.x = face.left();
-			bestFaceBox.y = face.top();
-			bestFaceBox.width = face.right() - bestFaceBox.x;
-			bestFaceBox.height = face.bottom() - bestFaceBox.y;
-			bestFaceBox = Utilities::insetBox(bestFaceBox, faceBoxSizeAdjustment) & detectionFrameBox;
-			bestFaceBoxNormalSize = Utilities::scaleRect(bestFaceBox, 1.0 / task.myDetectionScaleFactor);
+	Rect2d frameBoxNormalSize = Utilities::scaleRect(Rect2d(0.0, 0.0, detectionFrameSize.width, detectionFrameSize.height), 1.0 / task.myDetectionScaleFactor);
+	double frameShortSideNormalSize = std::min(frameBoxNormalSize.width, frameBoxNormalSize.height);
+	std::vector<Rect2d> facesNormalSize;
+	for(Rect2d face : faces) {
+		Rect2d faceNormalSize = Utilities::scaleRect(face, 1.0 / searchScaleFactor);
+		faceNormalSize.x += searchOffset.x;
+		faceNormalSize.y += searchOffset.y;
+		double faceSize = std::min(faceNormalSize.width, faceNormalSize.height);
+		if(faceSize < minimumFaceSize * frameShortSideNormalSize || faceSize > maximumFaceSize * frameShortSideNormalSize) {
+			continue;
 		}
+		facesNormalSize.push_back(faceNormalSize);
 	}
+	//Keep the largest faces. (Stable IDs are assigned later, in frame order, by the assignment thread.)
+	std::sort(facesNormalSize.begin(), facesNormalSize.end(), [](const Rect2d &a, const Rect2d &b) {
+		return a.area() > b.area();
+	});
+	if(facesNormalSize.size() > (size_t)maxFaces) {
+		facesNormalSize.resize(maxFaces);
+	}
+
 	FacialDetectionBox detection;
 	detection.timestamps = task.myFrameTimestamps;
 	detection.run = true;
 	detection.set = false;
-	if(bestFaceSet) {
-		detection.box = bestFaceBox;
-		detection.boxNormalSize = bestFaceBoxNormalSize;
+	for(Rect2d faceNormalSize : facesNormalSize) {
+		FacialDetectionFace detectionFace;
+		detectionFace.faceId = -1;
+		detectionFace.boxNormalSize = Utilities::insetBox(faceNormalSize, faceBoxSizeAdjustment) & frameBoxNormalSize;
+		detectionFace.box = Utilities::scaleRect(detectionFace.boxNormalSize, task.myDetectionScaleFactor);
+		detection.faces.push_back(detectionFace);
+	}
+	if(detection.faces.size() > 0) {
+		detection.box = detection.faces[0].box;
+		detection.boxNormalSize = detection.faces[0].boxNormalSize;
 		detection.set = true;
 	}
 
-	logger->debug4("==== WORKER #%d FINISHED DETECTION FOR FRAME #" YERFACE_FRAMENUMBER_FORMAT, workerPoolWorker->num, detection.timestamps.frameNumber);
+	YerFace_LogDebug4(logger, "==== WORKER #%d FINISHED DETECTION FOR FRAME #" YERFACE_FRAMENUMBER_FORMAT, workerPoolWorker->num, detection.timestamps.frameNumber);
+
+	YerFace_MutexLock(myMutex);
+	summaryDetections++;
+	if(detection.set) {
+		summaryDetectionsWithFace++;
+	}
+	YerFace_MutexUnlock(myMutex);
 
 	bool resultUsed = false;
 	YerFace_MutexLock(detectionsMutex);
+	if(scheduledDetection) {
+		scheduledDetections[detection.timestamps.frameNumber] = detection;
+		resultUsed = true;
+	}
 	if(!latestDetection.run || latestDetection.timestamps.startTimestamp < detection.timestamps.startTimestamp) {
 		latestDetection = detection;
 		resultUsed = true;
@@ -227,10 +605,150 @@ void FaceDetector::doDetectFace(WorkerPoolWorker *workerPoolWorker, FaceDetectio
 	}
 }
 
+void FaceDetector::doAssociateFaces(FacialDetectionBox *detection, FrameTimestamps frameTimestamps) {
+	//Greedily match each face (largest first) to the known face it overlaps most. Unmatched faces get new IDs.
+	std::vector<bool> knownFaceMatched(knownFaces.size(), false);
+	for(FacialDetectionFace &face : detection->faces) {
+		double bestOverlap = faceAssociationMinimumOverlap;
+		int bestKnownFace = -1;
+		for(size_t i = 0; i < knownFaces.size(); i++) {
+			if(knownFaceMatched[i]) {
+				continue;
+			}
+			double overlap = Utilities::boxOverlap(face.boxNormalSize, knownFaces[i].face.boxNormalSize);
+			if(overlap >= bestOverlap) {
+				bestOverlap = overlap;
+				bestKnownFace = (int)i;
+			}
+		}
+		if(bestKnownFace >= 0) {
+			knownFaceMatched[bestKnownFace] = true;
+			face.faceId = knownFaces[bestKnownFace].face.faceId;
+			knownFaces[bestKnownFace].face = face;
+			knownFaces[bestKnownFace].lastSeenTimestamp = frameTimestamps.startTimestamp;
+		} else {
+			face.faceId = nextFaceId++;
+			FaceDetectorKnownFace knownFace;
+			knownFace.face = face;
+			knownFace.lastSeenTimestamp = frameTimestamps.startTimestamp;
+			knownFaces.push_back(knownFace);
+			knownFaceMatched.push_back(true);
+			YerFace_LogDebug1(logger, "New face #%d found on frame #" YERFACE_FRAMENUMBER_FORMAT ".", face.faceId, frameTimestamps.frameNumber);
+		}
+	}
+
+	//Faces we haven't seen in a while are forgotten, so if they come back they will get new IDs.
+	for(auto iterator = knownFaces.begin(); iterator != knownFaces.end();) {
+		if(frameTimestamps.startTimestamp - iterator->lastSeenTimestamp > faceForgetAfterSeconds) {
+			YerFace_LogDebug1(logger, "Forgetting face #%d.", iterator->face.faceId);
+			iterator = knownFaces.erase(iterator);
+		} else {
+			++iterator;
+		}
+	}
+}
+
+void FaceDetector::enqueueDetectionTask(WorkingFrame *workingFrame) {
+	FaceDetectionTask task;
+	task.myFrameNumber = workingFrame->frameTimestamps.frameNumber;
+	task.myFrameTimestamps = workingFrame->frameTimestamps;
+	task.myDetectionScaleFactor = workingFrame->detectionScaleFactor;
+	//No need to clone. Nothing writes to detectionFrame once it has been scaled, and the Mat is reference counted,
+	//so our copy of the header keeps the pixels alive even after FrameServer releases its own reference.
+	task.detectionFrame = workingFrame->detectionFrame;
+	task.searchRegionOfInterest = false;
+
+	if(roiSearchEnabled) {
+		YerFace_MutexLock(detectionsMutex);
+		FacialDetectionBox previousDetection = latestDetection;
+		YerFace_MutexUnlock(detectionsMutex);
+
+		YerFace_MutexLock(myMutex);
+		if(previousDetection.set && task.myFrameTimestamps.startTimestamp < lastFullFrameSearchTimestamp + roiSearchFullFrameEverySeconds) {
+			task.searchRegionOfInterest = true;
+		} else {
+			lastFullFrameSearchTimestamp = task.myFrameTimestamps.startTimestamp;
+		}
+		YerFace_MutexUnlock(myMutex);
+
+		if(task.searchRegionOfInterest) {
+			Rect2d frameBox = Rect2d(0.0, 0.0, workingFrame->frame.cols, workingFrame->frame.rows);
+			Rect roi = Rect(Utilities::insetBox(previousDetection.boxNormalSize, roiSearchBoxScale) & frameBox);
+			if(roi.area() > 0) {
+				//Search the region of interest at up to full resolution, but never with more pixels than a full frame search would cost.
+				task.roiScaleFactor = std::min(1.0, sqrt((double)workingFrame->detectionFrame.total() / (double)roi.area()));
+				if(detectorMinimumFacePixels > 0 && minimumFaceSize > 0.0) {
+					double usefulScaleFactor = (double)detectorMinimumFacePixels / (minimumFaceSize * (double)std::min(workingFrame->frame.cols, workingFrame->frame.rows));
+					task.roiScaleFactor = std::min(task.roiScaleFactor, usefulScaleFactor);
+				}
+				task.roiOffset = roi.tl();
+				if(task.roiScaleFactor < 1.0) {
+					cv::resize(workingFrame->frame(roi), task.roiFrame, Size(), task.roiScaleFactor, task.roiScaleFactor);
+				} else {
+					task.roiFrame = workingFrame->frame(roi); //A view into the (read-only, reference counted) full sized frame.
+				}
+			} else {
+				task.searchRegionOfInterest = false;
+			}
+		}
+	}
+
+	YerFace_MutexLock(myMutex);
+	detectionTasks.push_back(task);
+	YerFace_MutexUnlock(myMutex);
+	if(detectionWorkerPool != NULL) {
+		detectionWorkerPool->sendWorkerSignal();
+	}
+}
+
+bool FaceDetector::getIsScheduledDetectionFrame(FrameNumber frameNumber) {
+	YerFace_MutexLock(detectionsMutex);
+	bool scheduled = firstFrameNumber >= 0 && (frameNumber - firstFrameNumber) % offlineDetectionEveryNFrames == 0;
+	YerFace_MutexUnlock(detectionsMutex);
+	return scheduled;
+}
+
+bool FaceDetector::getScheduledDetection(FrameNumber frameNumber, bool frameServerDraining, FacialDetectionBox *detection) {
+	//// WARNING! Call this with detectionsMutex locked. (Which is why frameServerDraining is passed in, rather than checked here.)
+	FrameNumber offset = (frameNumber - firstFrameNumber) % offlineDetectionEveryNFrames;
+	FrameNumber sourceFrameNumber = frameNumber - offset;
+	FrameNumber nextScheduledFrameNumber = sourceFrameNumber + offlineDetectionEveryNFrames;
+	if(offset > 0 && nextScheduledFrameNumber - frameNumber < offset) {
+		//The next scheduled detection is nearer, but at the end of the stream it may never exist.
+		if(!frameServerDraining || detections.find(nextScheduledFrameNumber) != detections.end()) {
+			sourceFrameNumber = nextScheduledFrameNumber;
+		}
+	}
+	auto scheduledDetectionIter = scheduledDetections.find(sourceFrameNumber);
+	if(scheduledDetectionIter == scheduledDetections.end()) {
+		return false;
+	}
+	*detection = scheduledDetectionIter->second;
+
+	//Frames are assigned in order, so nothing from before this frame's preceding scheduled detection is needed anymore.
+	scheduledDetections.erase(scheduledDetections.begin(), scheduledDetections.lower_bound(frameNumber - offset));
+	return true;
+}
+
+void FaceDetector::handleFrameServerStallEvent(void *userdata) {
+	FaceDetector *self = (FaceDetector *)userdata;
+	YerFace_MutexLock(self->myMutex);
+	size_t detectionTasksDepth = self->detectionTasks.size();
+	YerFace_MutexUnlock(self->myMutex);
+	YerFace_MutexLock(self->myAssignmentMutex);
+	size_t assignmentDepth = self->assignmentFrameNumbers.size();
+	YerFace_MutexUnlock(self->myAssignmentMutex);
+	YerFace_MutexLock(self->detectionsMutex);
+	size_t detectionsDepth = self->detections.size();
+	size_t scheduledDetectionsDepth = self->scheduledDetections.size();
+	YerFace_MutexUnlock(self->detectionsMutex);
+	self->logger->warning("... Queue depths: <Detection Tasks: %lu, Pending Assignments: %lu, Detections: %lu, Scheduled Detections: %lu>", detectionTasksDepth, assignmentDepth, detectionsDepth, scheduledDetectionsDepth);
+}
+
 void FaceDetector::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
 	FaceDetector *self = (FaceDetector *)userdata;
-	self->logger->debug4("Handling Frame Status Change for Frame Number " YERFACE_FRAMENUMBER_FORMAT " to Status %d", frameNumber, newStatus);
+	YerFace_LogDebug4(self->logger, "Handling Frame Status Change for Frame Number " YERFACE_FRAMENUMBER_FORMAT " to Status %d", frameNumber, newStatus);
 	FacialDetectionBox detection;
 	FaceDetectorAssignmentTask assignment;
 	switch(newStatus) {
@@ -241,6 +759,9 @@ void FaceDetector::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			detection.set = false;
 			YerFace_MutexLock(self->detectionsMutex);
 			self->detections[frameNumber] = detection;
+			if(self->firstFrameNumber < 0) {
+				self->firstFrameNumber = frameNumber;
+			}
 			YerFace_MutexUnlock(self->detectionsMutex);
 			assignment.frameNumber = frameNumber;
 			assignment.readyForAssignment = false;
@@ -251,8 +772,12 @@ void FaceDetector::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 		case FRAME_STATUS_DETECTION:
 			YerFace_MutexLock(self->myAssignmentMutex);
 			self->assignmentFrameNumbers[frameNumber].readyForAssignment = true;
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->assignmentFrameNumbers.size());
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->assignmentFrameNumbers.size());
 			YerFace_MutexUnlock(self->myAssignmentMutex);
+			if(self->scheduledDetection && self->getIsScheduledDetectionFrame(frameNumber)) {
+				//Queue scheduled detections as soon as the frame is ready, so the detection workers can run ahead of assignment.
+				self->enqueueDetectionTask(self->frameServer->getWorkingFrame(frameNumber));
+			}
 			if(self->assignmentWorkerPool != NULL) {
 				self->assignmentWorkerPool->sendWorkerSignal();
 			}
@@ -269,41 +794,79 @@ void FaceDetector::detectionWorkerInitializer(WorkerPoolWorker *worker, void *pt
 	FaceDetector *self = (FaceDetector *)ptr;
 	FaceDetectorWorker *innerWorker = new FaceDetectorWorker();
 	innerWorker->self = self;
-	if(self->usingDNNFaceDetection) {
-		deserialize(self->faceDetectionModelFileName.c_str()) >> innerWorker->faceDetectionModel;
-	} else {
-		innerWorker->frontalFaceDetector = get_frontal_face_detector();
+	YerFace_MutexLock(self->myMutex);
+	switch(self->detectionMethod) {
+		case FACE_DETECTION_METHOD_DLIB_HOG:
+			innerWorker->frontalFaceDetector = self->prototype->frontalFaceDetector;
+			innerWorker->limitedFrontalFaceDetector = &innerWorker->frontalFaceDetector;
+			break;
+		case FACE_DETECTION_METHOD_DLIB_MMOD:
+			innerWorker->faceDetectionModel = self->prototype->faceDetectionModel;
+			break;
+		case FACE_DETECTION_METHOD_OPENCV_DNN:
+			innerWorker->openCVNet = cv::dnn::readNet(self->openCVFramework, self->prototype->openCVModelBuffer, self->prototype->openCVConfigBuffer);
+			innerWorker->openCVNet.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+			innerWorker->openCVNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+			break;
 	}
+	self->prototypeCopies++;
+	self->doFreePrototypeIfCopied();
+	YerFace_MutexUnlock(self->myMutex);
 	worker->ptr = (void *)innerWorker;
 }
 
+void FaceDetector::doFreePrototypeIfCopied(void) {
+	if(prototype != NULL && detectionWorkerPool != NULL && prototypeCopies >= detectionWorkerPool->getNumWorkers()) {
+		YerFace_LogDebug2(logger, "Every detection worker has its own detector. Freeing the prototype.");
+		delete prototype;
+		prototype = NULL;
+	}
+}
+
 bool FaceDetector::detectionWorkerHandler(WorkerPoolWorker *worker) {
 	FaceDetectorWorker *innerWorker = (FaceDetectorWorker *)worker->ptr;
 	FaceDetector *self = innerWorker->self;
 	bool didWork = false;
 
 	//// CHECK FOR WORK ////
-	bool taskSet = false;
-	FaceDetectionTask task;
+	std::vector<FaceDetectionTask> tasks;
 	YerFace_MutexLock(self->myMutex);
-	if(self->detectionTasks.size() > 0) {
-		taskSet = true;
+	if(self->scheduledDetection) {
+		//Every scheduled detection matters, so this IS a FIFO queue. Take as many tasks as will fit in one batch.
+		size_t maxTasks = self->batchedDetection ? (size_t)self->offlineBatchSize : 1;
+		while(self->detectionTasks.size() > 0 && tasks.size() < maxTasks) {
+			tasks.push_back(self->detectionTasks.front());
+			self->detectionTasks.pop_front();
+		}
+	} else if(self->detectionTasks.size() > 0) {
 		//Operate on the back of detectionTasks (not a FIFO queue!) because the most recent detection task is always the most urgent.
-		task = self->detectionTasks.back();
+		tasks.push_back(self->detectionTasks.back());
 		self->detectionTasks.clear();
 	}
 	YerFace_MutexUnlock(self->myMutex);
 
 	//// DO THE WORK ////
-	if(taskSet) {
-		self->logger->debug4("Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT, worker->num, task.myFrameNumber);
+	if(tasks.size() > 0) {
+		YerFace_LogDebug4(self->logger, "Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT " (batch of %lu)", worker->num, tasks.front().myFrameNumber, tasks.size());
 		MetricsTick tick = self->metrics->startClock();
 
-		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - RUNNING Detection", worker->num, task.myFrameNumber);
-		self->doDetectFace(worker, task);
-		// self->logger->verbose("Thread #%d, Frame #" YERFACE_FRAMENUMBER_FORMAT " - FINISHED Detection", worker->num, task.myFrameNumber);
+		if(self->batchedDetection) {
+			self->doDetectFacesBatched(worker, tasks);
+		} else {
+			self->doDetectFace(worker, tasks.front());
+		}
 
 		self->metrics->endClock(tick);
+
+		double passSeconds = ((double)getTickCount() / (double)getTickFrequency()) - tick.startTime;
+		YerFace_MutexLock(self->myMutex);
+		self->summaryDetectionPasses++;
+		self->summaryDetectionPassSeconds += passSeconds;
+		if(passSeconds > self->summaryWorstDetectionPassSeconds) {
+			self->summaryWorstDetectionPassSeconds = passSeconds;
+		}
+		YerFace_MutexUnlock(self->myMutex);
+
 		didWork = true;
 	}
 	return didWork;
@@ -328,7 +891,7 @@ bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 			}
 		}
 		if(myFrameNumber > 0 && !self->assignmentFrameNumbers[myFrameNumber].readyForAssignment) {
-			self->logger->debug4("BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
+			YerFace_LogDebug4(self->logger, "BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 			myFrameNumber = -1;
 		}
 		if(myFrameNumber > 0) {
@@ -340,39 +903,50 @@ bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(myFrameNumber > 0) {
-		self->logger->debug4("Assignment Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
+		YerFace_LogDebug4(self->logger, "Assignment Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 		if(myFrameNumber <= lastFrameNumber) {
 			throw logic_error("FaceDetector handling frames out of order!");
 		}
 
 		WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(myFrameNumber);
 		FrameTimestamps myFrameTimestamps = workingFrame->frameTimestamps;
+		bool frameServerDraining = self->frameServer->getIsDraining();
+
+		YerFace_MutexLock(self->myMutex);
+		double redetectionInterval = self->redetectionIntervalSeconds;
+		YerFace_MutexUnlock(self->myMutex);
 
 		bool frameAssigned = false;
 		YerFace_MutexLock(self->detectionsMutex);
-		if(self->latestDetection.run) {
-			double latestDetectionUsableUntil = self->latestDetection.timestamps.startTimestamp + self->resultGoodForSeconds;
+		if(self->scheduledDetection) {
+			//Use whichever scheduled detection is nearest to this frame, waiting for it if necessary.
+			FacialDetectionBox nearestDetection;
+			if(self->getScheduledDetection(myFrameNumber, frameServerDraining, &nearestDetection)) {
+				self->doAssociateFaces(&nearestDetection, myFrameTimestamps);
+				self->detections[myFrameNumber] = nearestDetection;
+				frameAssigned = true;
+			}
+		} else if(self->latestDetection.run) {
+			//While tracking is healthy, detections are requested less often, so each one has to last that much longer.
+			double latestDetectionUsableUntil = self->latestDetection.timestamps.startTimestamp + self->resultGoodForSeconds + redetectionInterval;
 			if(myFrameTimestamps.startTimestamp <= latestDetectionUsableUntil) {
-				self->detections[myFrameNumber] = self->latestDetection;
+				FacialDetectionBox associatedDetection = self->latestDetection;
+				self->doAssociateFaces(&associatedDetection, myFrameTimestamps);
+				self->detections[myFrameNumber] = associatedDetection;
 				frameAssigned = true;
 				// self->logger->verbose("==== SUCCESSFUL ASSIGNMENT ON FRAME #" YERFACE_FRAMENUMBER_FORMAT " (LD Frame #" YERFACE_FRAMENUMBER_FORMAT ")", myFrameNumber, self->latestDetection.timestamps.frameNumber);
 			}
 		}
+		bool latestDetectionSet = self->latestDetection.set;
 		YerFace_MutexUnlock(self->detectionsMutex);
 
-		if(myFrameNumber != lastDetectionRequested) {
-			// self->logger->verbose("==== REQUESTING A DETECTION ON FRAME #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
-			lastDetectionRequested = myFrameNumber;
-			FaceDetectionTask task;
-			task.myFrameNumber = myFrameNumber;
-			task.myFrameTimestamps = myFrameTimestamps;
-			task.myDetectionScaleFactor = workingFrame->detectionScaleFactor;
-			task.detectionFrame = workingFrame->detectionFrame.clone();
-			YerFace_MutexLock(self->myMutex);
-			self->detectionTasks.push_back(task);
-			YerFace_MutexUnlock(self->myMutex);
-			if(self->detectionWorkerPool != NULL) {
-				self->detectionWorkerPool->sendWorkerSignal();
+		if(!self->scheduledDetection && myFrameNumber != lastDetectionRequested) {
+			bool detectionDue = !latestDetectionSet || !frameAssigned || myFrameTimestamps.startTimestamp >= self->lastDetectionRequestedTimestamp + redetectionInterval;
+			if(detectionDue) {
+				// self->logger->verbose("==== REQUESTING A DETECTION ON FRAME #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
+				lastDetectionRequested = myFrameNumber;
+				self->lastDetectionRequestedTimestamp = myFrameTimestamps.startTimestamp;
+				self->enqueueDetectionTask(workingFrame);
 			}
 		}
 
@@ -382,6 +956,9 @@ bool FaceDetector::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 			self->assignmentMetrics->endClock(tick);
 			myFrameNumber = -1;
 			didWork = true;
+		} else if(self->scheduledDetection) {
+			//Waiting on a scheduled detection is a normal part of offline processing.
+			YerFace_LogDebug3(self->logger, "Waiting on a scheduled Face Detection Task for frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 		} else {
 			if(lastFrameBlockedWarning != myFrameNumber) {
 				self->logger->warning("Uh-oh! We are blocked on a Face Detection Task for frame #" YERFACE_FRAMENUMBER_FORMAT ". If this happens a lot, consider some tuning.", myFrameNumber);
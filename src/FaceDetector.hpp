@@ -7,30 +7,66 @@
 #include "WorkerPool.hpp"
 
 #include <list>
+#include <map>
+#include <vector>
 
 using namespace std;
 
 namespace YerFace {
 
+enum FaceDetectionMethod {
+	FACE_DETECTION_METHOD_DLIB_HOG,
+	FACE_DETECTION_METHOD_DLIB_MMOD,
+	FACE_DETECTION_METHOD_OPENCV_DNN
+};
+
 class FaceDetectionTask {
 public:
 	FrameNumber myFrameNumber;
 	FrameTimestamps myFrameTimestamps;
 	double myDetectionScaleFactor;
 	cv::Mat detectionFrame;
+	bool searchRegionOfInterest; //If set, roiFrame is searched first. detectionFrame is only searched if that fails.
+	cv::Mat roiFrame;
+	cv::Point2d roiOffset; //Top left corner of roiFrame, in the coordinates of the full sized frame.
+	double roiScaleFactor; //Scale of roiFrame relative to the full sized frame.
 };
 
 class FaceDetectorWorker;
+class FaceDetectorPrototype;
+
+class FacialDetectionFace {
+public:
+	int faceId; //Stable across frames. Assigned by associating each box with the boxes of previous frames.
+	cv::Rect2d box;
+	cv::Rect2d boxNormalSize;
+};
 
 class FacialDetectionBox {
 public:
 	cv::Rect2d box;
 	cv::Rect2d boxNormalSize; //This is the scaled-up version to fit the native resolution of the frame.
+	std::vector<FacialDetectionFace> faces; //Every face found (up to maxFaces), largest first. The first face is the same as box.
 	FrameTimestamps timestamps; //The timestamp (including frame number) to which this detection belongs.
 	bool run; //Did the detector run?
 	bool set; //Is the box valid?
 };
 
+class FaceDetectorKnownFace {
+public:
+	FacialDetectionFace face;
+	double lastSeenTimestamp;
+};
+
+class FaceTrackingHealth {
+public:
+	FrameTimestamps timestamps;
+	bool landmarksSet; //Did the shape predictor produce landmarks at all?
+	bool poseRejected; //Did FaceTracker reject the facial pose solved from those landmarks?
+	double reprojectionError; //Mean solvePnP reprojection error, as a fraction of the width of the face.
+	double boxDrift; //Distance between the centers of a detector-style box fitted to the landmarks and the detection box, as a fraction of the width of the detection box.
+};
+
 class FaceDetectorAssignmentTask {
 public:
 	FrameNumber frameNumber;
@@ -39,25 +75,62 @@ public:
 
 class FaceDetector {
 public:
-	FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer);
+	FaceDetector(json config, Status *myStatus, FrameServer *myFrameServer, bool myLowLatency);
 	~FaceDetector() noexcept(false);
 	FacialDetectionBox getFacialDetection(FrameNumber frameNumber);
+	bool getTrackingHealthIsGood(FaceTrackingHealth health);
+	bool reportTrackingHealth(FaceTrackingHealth health); //Returns true if tracking is considered healthy.
+	int getMaxFaces(void);
+	double getFaceAssociationMinimumOverlap(void);
+	void reportTrackedFace(int faceId, cv::Rect2d boxNormalSize, FrameTimestamps frameTimestamps);
 	void renderPreviewHUD(cv::Mat previewFrame, FrameNumber frameNumber, int density, bool mirrorMode);
 private:
 	void doDetectFace(WorkerPoolWorker *worker, FaceDetectionTask task);
+	std::vector<cv::Rect2d> doDetectFacesInImage(FaceDetectorWorker *worker, cv::Mat image, double maximumFacePixels);
+	void doLimitHOGPyramidLevels(FaceDetectorWorker *worker, double maximumFacePixels);
+	void doDetectFacesBatched(WorkerPoolWorker *worker, std::vector<FaceDetectionTask> tasks);
+	void doProcessDetectedFaces(WorkerPoolWorker *worker, FaceDetectionTask task, std::vector<cv::Rect2d> faces, cv::Point2d searchOffset, double searchScaleFactor);
+	void enqueueDetectionTask(WorkingFrame *workingFrame);
+	void doAssociateFaces(FacialDetectionBox *detection, FrameTimestamps frameTimestamps);
+	bool getIsScheduledDetectionFrame(FrameNumber frameNumber);
+	bool getScheduledDetection(FrameNumber frameNumber, bool frameServerDraining, FacialDetectionBox *detection);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static void detectionWorkerInitializer(WorkerPoolWorker *worker, void *ptr);
 	static bool detectionWorkerHandler(WorkerPoolWorker *worker);
 	static bool assignmentWorkerHandler(WorkerPoolWorker *worker);
 
 	string faceDetectionModelFileName;
 	double resultGoodForSeconds, faceBoxSizeAdjustment;
-
-	bool usingDNNFaceDetection;
+	double minimumFaceSize, maximumFaceSize; //Fractions of the shorter side of the frame.
+	int maxFaces;
+	double faceAssociationMinimumOverlap, faceForgetAfterSeconds;
+	int detectorMinimumFacePixels;
+
+	FaceDetectionMethod detectionMethod;
+	string detectionMethodString;
+	string openCVModelFileName, openCVConfigFileName, openCVFramework;
+	int openCVInputSize;
+	cv::Scalar openCVMean;
+	double openCVConfidenceThreshold;
+
+	bool lowLatency;
+	int offlineBatchSize;
+	int offlineDetectionEveryNFrames;
+	bool scheduledDetection; //In offline mode, detection runs on a fixed schedule of frame numbers so results are reproducible.
+	bool batchedDetection; //Scheduled detection tasks may be run through the CNN in batches.
+	bool roiSearchEnabled;
+	double roiSearchBoxScale, roiSearchFullFrameEverySeconds;
+	bool adaptiveRedetectionEnabled; //In low latency mode, detection cadence follows the health of tracking reported by FaceTracker.
+	double adaptiveRedetectionMaxIntervalSeconds, adaptiveRedetectionMaxReprojectionError, adaptiveRedetectionMaxBoxDrift;
 
 	Status *status;
 	FrameServer *frameServer;
 
+	FaceDetectorPrototype *prototype; //Freed once every detection worker has its own copy. Protected by myMutex.
+	int prototypeCopies;
+	void doFreePrototypeIfCopied(void);
+
 	Metrics *metrics, *assignmentMetrics;
 
 	string outputPrefix;
@@ -66,11 +139,19 @@ private:
 	
 	SDL_mutex *myMutex;
 	list<FaceDetectionTask> detectionTasks;
+	double lastFullFrameSearchTimestamp;
+	double redetectionIntervalSeconds, lastDetectionRequestedTimestamp;
+	unsigned long summaryDetections, summaryDetectionsWithFace, summaryDetectionPasses;
+	double summaryDetectionPassSeconds, summaryWorstDetectionPassSeconds;
 
 	SDL_mutex *detectionsMutex;
 	unordered_map<FrameNumber, FacialDetectionBox> detections;
+	map<FrameNumber, FacialDetectionBox> scheduledDetections;
+	FrameNumber firstFrameNumber;
 	FacialDetectionBox latestDetection;
 	bool latestDetectionLostWarning;
+	std::vector<FaceDetectorKnownFace> knownFaces;
+	int nextFaceId;
 
 	SDL_mutex *myAssignmentMutex;
 	unordered_map<FrameNumber, FaceDetectorAssignmentTask> assignmentFrameNumbers;
@@ -0,0 +1,117 @@
+#pragma once
+
+namespace YerFace {
+
+//The 68 landmarks of the iBUG 300-W annotation scheme, as predicted by dlib's stock shape predictor.
+#define YERFACE_NUM_FACE_LANDMARKS 68
+
+enum DlibFeatureIndexes {
+	IDX_JAWLINE_0 = 0, //Uppermost right side.
+	IDX_JAWLINE_1 = 1,
+	IDX_JAWLINE_2 = 2,
+	IDX_JAWLINE_3 = 3,
+	IDX_JAWLINE_4 = 4,
+	IDX_JAWLINE_5 = 5,
+	IDX_JAWLINE_6 = 6,
+	IDX_JAWLINE_7 = 7,
+	IDX_JAWLINE_8 = 8, //Chin
+	IDX_JAWLINE_9 = 9,
+	IDX_JAWLINE_10 = 10,
+	IDX_JAWLINE_11 = 11,
+	IDX_JAWLINE_12 = 12,
+	IDX_JAWLINE_13 = 13,
+	IDX_JAWLINE_14 = 14,
+	IDX_JAWLINE_15 = 15,
+	IDX_JAWLINE_16 = 16, //Uppermost left side.
+	IDX_LEFTEYEBROW_FAROUTER = 17,
+	IDX_LEFTEYEBROW_NEAROUTER = 18,
+	IDX_LEFTEYEBROW_MIDDLE = 19,
+	IDX_LEFTEYEBROW_NEARINNER = 20,
+	IDX_LEFTEYEBROW_FARINNER = 21,
+	IDX_RIGHTEYEBROW_FARINNER = 22,
+	IDX_RIGHTEYEBROW_NEARINNER = 23,
+	IDX_RIGHTEYEBROW_MIDDLE = 24,
+	IDX_RIGHTEYEBROW_NEAROUTER = 25,
+	IDX_RIGHTEYEBROW_FAROUTER = 26,
+	IDX_NOSE_SELLION = 27, //Bridge of the nose
+	IDX_NOSE_TIP = 30,
+	IDX_RIGHTEYE_OUTER_CORNER = 36,
+	IDX_RIGHTEYE_UPPERLID_RIGHT = 37,
+	IDX_RIGHTEYE_UPPERLID_LEFT = 38,
+	IDX_RIGHTEYE_INNER_CORNER = 39,
+	IDX_RIGHTEYE_LOWERLID_LEFT = 40,
+	IDX_RIGHTEYE_LOWERLID_RIGHT = 41,
+	IDX_LEFTEYE_INNER_CORNER = 42,
+	IDX_LEFTEYE_UPPERLID_RIGHT = 43,
+	IDX_LEFTEYE_UPPERLID_LEFT = 44,
+	IDX_LEFTEYE_OUTER_CORNER = 45,
+	IDX_LEFTEYE_LOWERLID_LEFT = 46,
+	IDX_LEFTEYE_LOWERLID_RIGHT = 47,
+	IDX_MOUTHOUT_RIGHT_CORNER = 48,
+	IDX_MOUTHOUT_RIGHT_FAROUTER_TOP = 49,
+	IDX_MOUTHOUT_RIGHT_NEAROUTER_TOP = 50,
+	IDX_MOUTHOUT_CENTER_TOP = 51,
+	IDX_MOUTHOUT_LEFT_NEAROUTER_TOP = 52,
+	IDX_MOUTHOUT_LEFT_FAROUTER_TOP = 53,
+	IDX_MOUTHOUT_LEFT_CORNER = 54,
+	IDX_MOUTHOUT_LEFT_FAROUTER_BOTTOM = 55,
+	IDX_MOUTHOUT_LEFT_NEAROUTER_BOTTOM = 56,
+	IDX_MOUTHOUT_CENTER_BOTTOM = 57,
+	IDX_MOUTHOUT_RIGHT_NEAROUTER_BOTTOM = 58,
+	IDX_MOUTHOUT_RIGHT_FAROUTER_BOTTOM = 59,
+	IDX_MOUTHIN_RIGHT_CORNER = 60,
+	IDX_MOUTHIN_RIGHT_TOP = 61,
+	IDX_MOUTHIN_CENTER_TOP = 62,
+	IDX_MOUTHIN_LEFT_TOP = 63,
+	IDX_MOUTHIN_LEFT_CORNER = 64,
+	IDX_MOUTHIN_LEFT_BOTTOM = 65,
+	IDX_MOUTHIN_CENTER_BOTTOM = 66,
+	IDX_MOUTHIN_RIGHT_BOTTOM = 67
+};
+
+//Every landmark read by FaceTracker (solvePnP) or MarkerTracker. A reduced shape predictor has to predict at least these.
+static const int requiredFaceLandmarkIndexes[] = {
+	IDX_JAWLINE_0,
+	IDX_JAWLINE_7,
+	IDX_JAWLINE_8,
+	IDX_JAWLINE_9,
+	IDX_JAWLINE_16,
+	IDX_LEFTEYEBROW_FAROUTER,
+	IDX_LEFTEYEBROW_NEAROUTER,
+	IDX_LEFTEYEBROW_MIDDLE,
+	IDX_LEFTEYEBROW_NEARINNER,
+	IDX_LEFTEYEBROW_FARINNER,
+	IDX_RIGHTEYEBROW_FARINNER,
+	IDX_RIGHTEYEBROW_NEARINNER,
+	IDX_RIGHTEYEBROW_MIDDLE,
+	IDX_RIGHTEYEBROW_NEAROUTER,
+	IDX_RIGHTEYEBROW_FAROUTER,
+	IDX_NOSE_SELLION,
+	IDX_NOSE_TIP,
+	IDX_RIGHTEYE_OUTER_CORNER,
+	IDX_RIGHTEYE_UPPERLID_RIGHT,
+	IDX_RIGHTEYE_UPPERLID_LEFT,
+	IDX_RIGHTEYE_LOWERLID_LEFT,
+	IDX_RIGHTEYE_LOWERLID_RIGHT,
+	IDX_LEFTEYE_UPPERLID_RIGHT,
+	IDX_LEFTEYE_UPPERLID_LEFT,
+	IDX_LEFTEYE_OUTER_CORNER,
+	IDX_LEFTEYE_LOWERLID_LEFT,
+	IDX_LEFTEYE_LOWERLID_RIGHT,
+	IDX_MOUTHOUT_RIGHT_CORNER,
+	IDX_MOUTHOUT_RIGHT_FAROUTER_TOP,
+	IDX_MOUTHOUT_RIGHT_NEAROUTER_TOP,
+	IDX_MOUTHOUT_LEFT_NEAROUTER_TOP,
+	IDX_MOUTHOUT_LEFT_FAROUTER_TOP,
+	IDX_MOUTHOUT_LEFT_CORNER,
+	IDX_MOUTHOUT_LEFT_FAROUTER_BOTTOM,
+	IDX_MOUTHOUT_LEFT_NEAROUTER_BOTTOM,
+	IDX_MOUTHOUT_RIGHT_NEAROUTER_BOTTOM,
+	IDX_MOUTHOUT_RIGHT_FAROUTER_BOTTOM,
+	IDX_MOUTHIN_RIGHT_CORNER,
+	IDX_MOUTHIN_CENTER_TOP,
+	IDX_MOUTHIN_LEFT_CORNER,
+	IDX_MOUTHIN_CENTER_BOTTOM
+};
+
+}; //namespace YerFace
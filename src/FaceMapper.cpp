@@ -94,6 +94,12 @@ FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_MAPPING without our blessing.
 	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_MAPPING, "faceMapper.ran");
 
@@ -113,6 +119,8 @@ FaceMapper::FaceMapper(json config, Status *myStatus, FrameServer *myFrameServer
 FaceMapper::~FaceMapper() noexcept(false) {
 	logger->debug1("FaceMapper object destructing...");
 
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	delete workerPool;
 
 	YerFace_MutexLock(myMutex);
@@ -175,11 +183,25 @@ FaceTracker *FaceMapper::getFaceTracker(void) {
 	return faceTracker;
 }
 
+void FaceMapper::handleFrameServerStallEvent(void *userdata) {
+	FaceMapper *self = (FaceMapper *)userdata;
+	YerFace_MutexLock(self->myMutex);
+	size_t pendingDepth = self->pendingFrames.size();
+	size_t mappingDepth = 0;
+	for(auto pendingFramePair : self->pendingFrames) {
+		if(pendingFramePair.second.hasEnteredMapping && !pendingFramePair.second.hasCompletedMapping) {
+			mappingDepth++;
+		}
+	}
+	YerFace_MutexUnlock(self->myMutex);
+	self->logger->warning("... Queue depths: <Pending Frames: %lu, Waiting for Mapping: %lu>", pendingDepth, mappingDepth);
+}
+
 void FaceMapper::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
 	FaceMapper *self = (FaceMapper *)userdata;
 	FaceMapperPendingFrame newFrame;
-	self->logger->debug4("Handling Frame Status Change for Frame Number " YERFACE_FRAMENUMBER_FORMAT " to Status %d", frameNumber, newStatus);
+	YerFace_LogDebug4(self->logger, "Handling Frame Status Change for Frame Number " YERFACE_FRAMENUMBER_FORMAT " to Status %d", frameNumber, newStatus);
 	switch(newStatus) {
 		default:
 			throw logic_error("Handler passed unsupported frame status change event!");
@@ -195,7 +217,7 @@ void FaceMapper::handleFrameStatusChange(void *userdata, WorkingFrameStatus newS
 			}
 			break;
 		case FRAME_STATUS_MAPPING:
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " entered MAPPING.", frameNumber);
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " entered MAPPING.", frameNumber);
 			YerFace_MutexLock(self->myMutex);
 			self->pendingFrames[frameNumber].hasEnteredMapping = true;
 			YerFace_MutexUnlock(self->myMutex);
@@ -236,7 +258,7 @@ bool FaceMapper::workerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(myFrameNumber > 0) {
-		self->logger->debug4("Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT, worker->num, myFrameNumber);
+		YerFace_LogDebug4(self->logger, "Thread #%d handling frame #" YERFACE_FRAMENUMBER_FORMAT, worker->num, myFrameNumber);
 		if(myFrameNumber <= lastFrameNumber) {
 			throw logic_error("FaceMapper handling frames out of order!");
 		}
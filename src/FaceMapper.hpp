@@ -31,6 +31,7 @@ public:
 	FaceTracker *getFaceTracker(void);
 private:
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static bool workerHandler(WorkerPoolWorker *worker);
 
 	Status *status;
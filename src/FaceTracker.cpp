@@ -9,7 +9,9 @@
 #include "dlib/image_processing.h"
 
 #include "opencv2/calib3d.hpp"
+#include "opencv2/video/tracking.hpp"
 
+#include <algorithm>
 #include <exception>
 #include <cmath>
 #include <cstdio>
@@ -21,10 +23,20 @@ using namespace cv;
 
 namespace YerFace {
 
-class DlibPointPointer {
-public:
-	dlib::point *ptr;
-};
+//How much room to leave around the landmarks when cropping for optical flow, so that the face is still inside the crop on the next frame.
+#define YERFACE_OPTICAL_FLOW_ROI_SCALE 1.5
+
+//Leave a little context around the search box when cropping for the shape predictor.
+#define YERFACE_ADAPTIVE_CROP_ROI_SCALE 1.25
+
+//Roughly how wide the eyes (outer corners) are compared to a face search box, whether it came from the detector or from previous landmarks.
+#define YERFACE_INTEROCULAR_TO_SEARCH_BOX_RATIO 0.5
+
+//Rotation rejection thresholds are configured in the units of the old trace-based matrix difference, which reported about 1/sqrt(2) of the true angle for small rotations.
+#define YERFACE_ROTATION_THRESHOLD_TO_DEGREES 1.4142135623730951
+
+//Roughly how far the chin sits below the line between the eyes, compared to the side of a detector box.
+#define YERFACE_EYES_TO_CHIN_TO_SEARCH_BOX_RATIO 0.65
 
 class FaceTrackerWorker {
 public:
@@ -37,14 +49,109 @@ public:
 // Pose recovery approach largely informed by the following sources:
 //  - https://www.learnopencv.com/head-pose-estimation-using-opencv-and-dlib/
 //  - https://github.com/severin-lemaignan/gazr/
-FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver, FrameServer *myFrameServer, FaceDetector *myFaceDetector) {
+FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver, FrameServer *myFrameServer, FaceDetector *myFaceDetector, bool myLowLatency) {
 	predictorWorkerPool = NULL;
 	assignmentWorkerPool = NULL;
 
 	featureDetectionModelFileName = Utilities::fileValidPathOrDie(config["YerFace"]["FaceTracker"]["dlibFaceLandmarks"]);
+	json landmarkIndexesArray = config["YerFace"]["FaceTracker"]["dlibFaceLandmarksIndexes"];
+	if(!landmarkIndexesArray.is_array()) {
+		throw invalid_argument("dlibFaceLandmarksIndexes must be an array of landmark indexes.");
+	}
+	landmarkPredicted.assign(YERFACE_NUM_FACE_LANDMARKS, false);
+	for(json landmarkIndexJSON : landmarkIndexesArray) {
+		if(!landmarkIndexJSON.is_number_integer()) {
+			throw invalid_argument("dlibFaceLandmarksIndexes contains an element which is not a valid integer.");
+		}
+		int landmarkIndex = landmarkIndexJSON;
+		if(landmarkIndex < 0 || landmarkIndex >= YERFACE_NUM_FACE_LANDMARKS) {
+			throw invalid_argument("dlibFaceLandmarksIndexes contains an index which is out of range.");
+		}
+		if(landmarkPredicted[landmarkIndex]) {
+			throw invalid_argument("dlibFaceLandmarksIndexes contains a duplicate index.");
+		}
+		landmarkPredicted[landmarkIndex] = true;
+		landmarkIndexes.push_back(landmarkIndex);
+	}
+	if(landmarkIndexes.size() == 0) {
+		//An empty mapping means the stock model, which predicts every landmark in order.
+		for(int landmarkIndex = 0; landmarkIndex < YERFACE_NUM_FACE_LANDMARKS; landmarkIndex++) {
+			landmarkPredicted[landmarkIndex] = true;
+			landmarkIndexes.push_back(landmarkIndex);
+		}
+	}
+	for(int landmarkIndex : requiredFaceLandmarkIndexes) {
+		if(!landmarkPredicted[landmarkIndex]) {
+			throw invalid_argument("dlibFaceLandmarksIndexes is missing landmark " + to_string(landmarkIndex) + ", which is required by FaceTracker or MarkerTracker.");
+		}
+	}
+	for(int landmarkIndex = 0; landmarkIndex < YERFACE_NUM_FACE_LANDMARKS; landmarkIndex++) {
+		if(!landmarkPredicted[landmarkIndex]) {
+			unpredictedLandmarkIndexes.push_back(landmarkIndex);
+		}
+	}
 	useFullSizedFrameForLandmarkDetection = config["YerFace"]["FaceTracker"]["useFullSizedFrameForLandmarkDetection"];
-	previouslyReportedFacialPose.set = false;
+	adaptiveLandmarkCropEnabled = config["YerFace"]["FaceTracker"]["adaptiveLandmarkCropEnabled"];
+	adaptiveLandmarkCropInterOcularPixels = config["YerFace"]["FaceTracker"]["adaptiveLandmarkCropInterOcularPixels"];
+	if(adaptiveLandmarkCropInterOcularPixels <= 0.0) {
+		throw invalid_argument("adaptiveLandmarkCropInterOcularPixels cannot be less than or equal to zero.");
+	}
 	facialCameraModel.set = false;
+	lowLatency = myLowLatency;
+	landmarkBoxEnabled = config["YerFace"]["FaceTracker"]["landmarkBoxEnabled"];
+	if(landmarkBoxEnabled && !lowLatency) {
+		//Predictor workers run out of order, so which previous frame's landmarks are available would depend on timing. Offline results should be reproducible.
+		landmarkBoxEnabled = false;
+	}
+	landmarkBoxGoodForSeconds = config["YerFace"]["FaceTracker"]["landmarkBoxGoodForSeconds"];
+	if(landmarkBoxGoodForSeconds < 0.0) {
+		throw invalid_argument("landmarkBoxGoodForSeconds cannot be less than zero.");
+	}
+	opticalFlowEnabled = config["YerFace"]["FaceTracker"]["opticalFlowEnabled"];
+	if(opticalFlowEnabled && !lowLatency) {
+		//Same as the landmark box: which previous frame we propagate from would depend on timing.
+		opticalFlowEnabled = false;
+	}
+	opticalFlowFullPredictionIntervalSeconds = config["YerFace"]["FaceTracker"]["opticalFlowFullPredictionIntervalSeconds"];
+	if(opticalFlowFullPredictionIntervalSeconds < 0.0) {
+		throw invalid_argument("opticalFlowFullPredictionIntervalSeconds cannot be less than zero.");
+	}
+	opticalFlowMaxGapSeconds = config["YerFace"]["FaceTracker"]["opticalFlowMaxGapSeconds"];
+	if(opticalFlowMaxGapSeconds < 0.0) {
+		throw invalid_argument("opticalFlowMaxGapSeconds cannot be less than zero.");
+	}
+	opticalFlowMaxForwardBackwardError = config["YerFace"]["FaceTracker"]["opticalFlowMaxForwardBackwardError"];
+	if(opticalFlowMaxForwardBackwardError < 0.0) {
+		throw invalid_argument("opticalFlowMaxForwardBackwardError cannot be less than zero.");
+	}
+	opticalFlowWindowSize = config["YerFace"]["FaceTracker"]["opticalFlowWindowSize"];
+	if(opticalFlowWindowSize < 3) {
+		throw invalid_argument("opticalFlowWindowSize cannot be less than three.");
+	}
+	opticalFlowPyramidLevels = config["YerFace"]["FaceTracker"]["opticalFlowPyramidLevels"];
+	if(opticalFlowPyramidLevels < 0) {
+		throw invalid_argument("opticalFlowPyramidLevels cannot be less than zero.");
+	}
+	string landmarkFilterString = config["YerFace"]["FaceTracker"]["landmarkFilter"];
+	if(landmarkFilterString == "oneEuro") {
+		landmarkFilterEnabled = true;
+	} else if(landmarkFilterString == "none") {
+		landmarkFilterEnabled = false;
+	} else {
+		throw invalid_argument("FaceTracker landmarkFilter must be one of: oneEuro, none");
+	}
+	landmarkFilterMinCutoff = config["YerFace"]["FaceTracker"]["landmarkFilterMinCutoff"];
+	if(landmarkFilterMinCutoff <= 0.0) {
+		throw invalid_argument("landmarkFilterMinCutoff cannot be less than or equal to zero.");
+	}
+	landmarkFilterBeta = config["YerFace"]["FaceTracker"]["landmarkFilterBeta"];
+	if(landmarkFilterBeta < 0.0) {
+		throw invalid_argument("landmarkFilterBeta cannot be less than zero.");
+	}
+	landmarkFilterDerivativeCutoff = config["YerFace"]["FaceTracker"]["landmarkFilterDerivativeCutoff"];
+	if(landmarkFilterDerivativeCutoff <= 0.0) {
+		throw invalid_argument("landmarkFilterDerivativeCutoff cannot be less than or equal to zero.");
+	}
 
 	status = myStatus;
 	if(status == NULL) {
@@ -62,6 +169,28 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	if(faceDetector == NULL) {
 		throw invalid_argument("faceDetector cannot be NULL");
 	}
+	string poseSolverString = config["YerFace"]["FaceTracker"]["poseSolver"];
+	if(poseSolverString == "iterative") {
+		poseSolverMethod = SOLVEPNP_ITERATIVE;
+	} else if(poseSolverString == "epnp") {
+		poseSolverMethod = SOLVEPNP_EPNP;
+	} else {
+		throw invalid_argument("FaceTracker poseSolver must be one of: iterative, epnp");
+	}
+	poseSolverWarmStart = config["YerFace"]["FaceTracker"]["poseSolverWarmStart"];
+	if(poseSolverWarmStart && !lowLatency) {
+		//Poses are solved on the predictor workers, so which accepted pose is newest would depend on timing.
+		poseSolverWarmStart = false;
+	}
+	poseSolverRefine = config["YerFace"]["FaceTracker"]["poseSolverRefine"];
+	string poseSmoothingMethodString = config["YerFace"]["FaceTracker"]["poseSmoothingMethod"];
+	if(poseSmoothingMethodString == "recursive") {
+		poseSmoothingRecursive = true;
+	} else if(poseSmoothingMethodString == "window") {
+		poseSmoothingRecursive = false;
+	} else {
+		throw invalid_argument("FaceTracker poseSmoothingMethod must be one of: recursive, window");
+	}
 	poseSmoothingOverSeconds = config["YerFace"]["FaceTracker"]["poseSmoothingOverSeconds"];
 	if(poseSmoothingOverSeconds <= 0.0) {
 		throw invalid_argument("poseSmoothingOverSeconds cannot be less than or equal to zero.");
@@ -70,6 +199,8 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	if(poseSmoothingExponent <= 0.0) {
 		throw invalid_argument("poseSmoothingExponent cannot be less than or equal to zero.");
 	}
+	//The windowed weights have a mean age of T / (exponent + 1). An exponential filter with that time constant lags by the same amount.
+	poseSmoothingTimeConstant = poseSmoothingOverSeconds / (poseSmoothingExponent + 1.0);
 	poseRotationLowRejectionThreshold = config["YerFace"]["FaceTracker"]["poseRotationLowRejectionThreshold"];
 	if(poseRotationLowRejectionThreshold <= 0.0) {
 		throw invalid_argument("poseRotationLowRejectionThreshold cannot be less than or equal to zero.");
@@ -98,6 +229,9 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	if(poseRejectionResetAfterSeconds <= 0.0) {
 		throw invalid_argument("poseRejectionResetAfterSeconds cannot be less than or equal to zero.");
 	}
+	poseRotationLowRejectionThreshold *= YERFACE_ROTATION_THRESHOLD_TO_DEGREES;
+	poseRotationLowRejectionThresholdInternal *= YERFACE_ROTATION_THRESHOLD_TO_DEGREES;
+	poseRotationHighRejectionThreshold *= YERFACE_ROTATION_THRESHOLD_TO_DEGREES;
 	poseTranslationMaxX = config["YerFace"]["FaceTracker"]["poseTranslationMaxX"];
 	poseTranslationMinX = config["YerFace"]["FaceTracker"]["poseTranslationMinX"];
 	poseTranslationMaxY = config["YerFace"]["FaceTracker"]["poseTranslationMaxY"];
@@ -124,9 +258,31 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	depthSliceG = config["YerFace"]["FaceTracker"]["depthSlices"]["G"];
 	depthSliceH = config["YerFace"]["FaceTracker"]["depthSlices"]["H"];
 
+	//None of this changes from frame to frame, so build the lookup tables once.
+	markerTypeDepths[EyelidLeftTop] = depthSliceG;
+	markerTypeDepths[EyelidLeftBottom] = depthSliceG;
+	markerTypeDepths[EyelidRightTop] = depthSliceG;
+	markerTypeDepths[EyelidRightBottom] = depthSliceG;
+	markerTypeDepths[EyebrowLeftInner] = depthSliceE;
+	markerTypeDepths[EyebrowRightInner] = depthSliceE;
+	markerTypeDepths[EyebrowLeftMiddle] = depthSliceF;
+	markerTypeDepths[EyebrowRightMiddle] = depthSliceF;
+	markerTypeDepths[EyebrowLeftOuter] = depthSliceH;
+	markerTypeDepths[EyebrowRightOuter] = depthSliceH;
+	markerTypeDepths[LipsLeftCorner] = depthSliceD;
+	markerTypeDepths[LipsRightCorner] = depthSliceD;
+	markerTypeDepths[LipsLeftTop] = depthSliceC;
+	markerTypeDepths[LipsRightTop] = depthSliceC;
+	markerTypeDepths[LipsLeftBottom] = depthSliceB;
+	markerTypeDepths[LipsRightBottom] = depthSliceB;
+	markerTypeDepths[Jaw] = depthSliceA;
+	correlationLandmarkIndexes = { IDX_JAWLINE_0, IDX_JAWLINE_8, IDX_JAWLINE_16, IDX_NOSE_SELLION, IDX_NOSE_TIP, IDX_RIGHTEYE_OUTER_CORNER, IDX_LEFTEYE_OUTER_CORNER };
+	correlationVertices = { vertexRightEar, vertexMenton, vertexLeftEar, vertexNoseSellion, vertexNoseTip, vertexEyeRightOuterCorner, vertexEyeLeftOuterCorner, vertexStommion };
+
 	logger = new Logger("FaceTracker");
 	metricsPredictor = new Metrics(config, "FaceTracker.Predictor");
 	metricsAssignment = new Metrics(config, "FaceTracker.Assignment");
+	metricsTransformation = new Metrics(config, "FaceTracker.Transformation");
 
 	if((myMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
@@ -146,6 +302,12 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_TRACKING without our blessing.
 	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_TRACKING, "faceTracker.ran");
 
@@ -174,10 +336,12 @@ FaceTracker::FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver,
 FaceTracker::~FaceTracker() noexcept(false) {
 	logger->debug1("FaceTracker object destructing...");
 
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	delete predictorWorkerPool;
 
 	YerFace_MutexLock(myMutex);
-	if(pendingPredictionFrameNumbers.size() > 0) {
+	if(pendingPredictions.size() > 0) {
 		logger->err("Frames are still pending! Woe is me!");
 	}
 	if(outputFrames.size() > 0) {
@@ -194,105 +358,313 @@ FaceTracker::~FaceTracker() noexcept(false) {
 	SDL_DestroyMutex(myMutex);
 	SDL_DestroyMutex(myAssignmentMutex);
 	delete metricsPredictor;
+	delete metricsAssignment;
+	delete metricsTransformation;
 	delete logger;
 }
 
+static Rect2d getLandmarksBoundingBox(const std::vector<Point2d> &points) {
+	//cv::boundingRect() only accepts integer or single precision points.
+	if(points.size() < 1) {
+		return Rect2d();
+	}
+	Point2d topLeft = points[0], bottomRight = points[0];
+	for(Point2d point : points) {
+		topLeft.x = std::min(topLeft.x, point.x);
+		topLeft.y = std::min(topLeft.y, point.y);
+		bottomRight.x = std::max(bottomRight.x, point.x);
+		bottomRight.y = std::max(bottomRight.y, point.y);
+	}
+	return Rect2d(topLeft, bottomRight);
+}
+
+//Smoothing factor of a first order low pass filter with the given cutoff (Hz), sampled after the given number of seconds.
+static double getLowPassAlpha(double cutoff, double elapsed) {
+	double timeConstant = 1.0 / (2.0 * M_PI * cutoff);
+	return 1.0 / (1.0 + timeConstant / elapsed);
+}
+
+//The shape predictor was trained on detector boxes, so a search box built from landmarks has to frame the face the way the detector would.
+//  A bounding box of the landmarks is the wrong shape: it hugs the jaw and eyebrows, and shifts with whatever the landmarks got wrong.
+static Rect2d getDetectorStyleBoxFromLandmarks(const std::vector<Point2d> &landmarks) {
+	Point2d rightEye = landmarks[IDX_RIGHTEYE_OUTER_CORNER], leftEye = landmarks[IDX_LEFTEYE_OUTER_CORNER];
+	Point2d eyesCenter = (rightEye + leftEye) / 2.0;
+	double interOcularDistance = Utilities::lineDistance(rightEye, leftEye);
+	double eyesToChinDistance = Utilities::lineDistance(eyesCenter, landmarks[IDX_JAWLINE_8]);
+	//Turning the head shortens one of these distances, and nodding shortens the other. Whichever implies the bigger face is the better estimate.
+	double side = std::max(interOcularDistance / YERFACE_INTEROCULAR_TO_SEARCH_BOX_RATIO, eyesToChinDistance / YERFACE_EYES_TO_CHIN_TO_SEARCH_BOX_RATIO);
+	//Detector boxes are centered about halfway between the eyes and the tip of the nose.
+	Point2d center = (eyesCenter + landmarks[IDX_NOSE_TIP]) / 2.0;
+	return Rect2d(center.x - (side / 2.0), center.y - (side / 2.0), side, side);
+}
+
+void FaceTracker::doInitializeOutput(FaceTrackerOutput *output, FrameTimestamps frameTimestamps, int faceId) {
+	output->set = false;
+	output->frameNumber = frameTimestamps.frameNumber;
+	output->faceId = faceId;
+	output->facialFeatures.set = false;
+	output->facialFeatures.featuresExposed.set = false;
+	output->facialPose.set = false;
+	output->solvedPose.set = false;
+	output->solvedPoseInBounds = false;
+	output->health.timestamps = frameTimestamps;
+	output->health.landmarksSet = false;
+	output->health.poseRejected = false;
+	output->health.reprojectionError = 0.0;
+	output->health.boxDrift = 0.0;
+}
+
+bool FaceTracker::getFlowReferenceIsUsable(FaceTrackerFlowReference reference, FrameTimestamps frameTimestamps) {
+	return reference.set && reference.timestamps.frameNumber < frameTimestamps.frameNumber && frameTimestamps.startTimestamp - reference.timestamps.startTimestamp <= opticalFlowMaxGapSeconds;
+}
+
+Rect2d FaceTracker::getFlowReferenceBox(FaceTrackerFlowReference reference) {
+	std::vector<Point2d> landmarks(YERFACE_NUM_FACE_LANDMARKS);
+	for(size_t i = 0; i < reference.landmarks.size(); i++) {
+		landmarks[landmarkIndexes[i]] = Point2d(reference.landmarks[i]) / reference.searchFrameScaleFactor;
+	}
+	doParkUnpredictedLandmarks(&landmarks);
+	return getDetectorStyleBoxFromLandmarks(landmarks);
+}
+
+bool FaceTracker::getBoxIsDetectedFace(Rect2d boxNormalSize, FacialDetectionBox facialDetection) {
+	for(FacialDetectionFace face : facialDetection.faces) {
+		if(Utilities::boxOverlap(boxNormalSize, face.boxNormalSize) >= faceDetector->getFaceAssociationMinimumOverlap()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FaceTracker::doPropagateLandmarks(Mat searchFrame, double searchFrameScaleFactor, FaceTrackerOutput *output, FaceTrackerFlowReference reference, std::vector<Point2d> *landmarks) {
+	if(reference.landmarks.size() != landmarkIndexes.size() || reference.searchFrameScaleFactor != searchFrameScaleFactor || (reference.roi & Rect(0, 0, searchFrame.cols, searchFrame.rows)) != reference.roi) {
+		return false;
+	}
+	Mat grayROI;
+	cvtColor(searchFrame(reference.roi), grayROI, COLOR_BGR2GRAY);
+
+	Point2f roiOffset = Point2f(reference.roi.x, reference.roi.y);
+	std::vector<Point2f> previousPoints(reference.landmarks.size()), forwardPoints, backwardPoints;
+	for(size_t i = 0; i < reference.landmarks.size(); i++) {
+		previousPoints[i] = reference.landmarks[i] - roiOffset;
+	}
+	Rect2d previousBox = boundingRect(previousPoints);
+	if(previousBox.width <= 0.0) {
+		return false;
+	}
+
+	//Track forward, then back again. Landmarks which do not make it home are not to be trusted.
+	std::vector<uchar> forwardStatus, backwardStatus;
+	std::vector<float> error;
+	Size windowSize = Size(opticalFlowWindowSize, opticalFlowWindowSize);
+	calcOpticalFlowPyrLK(reference.grayROI, grayROI, previousPoints, forwardPoints, forwardStatus, error, windowSize, opticalFlowPyramidLevels);
+	calcOpticalFlowPyrLK(grayROI, reference.grayROI, forwardPoints, backwardPoints, backwardStatus, error, windowSize, opticalFlowPyramidLevels);
+
+	double worstError = 0.0;
+	for(size_t i = 0; i < previousPoints.size(); i++) {
+		if(!forwardStatus[i] || !backwardStatus[i]) {
+			YerFace_LogDebug4(logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " lost landmark %d to optical flow.", output->faceId, output->frameNumber, landmarkIndexes[i]);
+			return false;
+		}
+		worstError = std::max(worstError, Utilities::lineDistance(Point2d(previousPoints[i]), Point2d(backwardPoints[i])));
+	}
+	worstError = worstError / previousBox.width;
+	if(worstError > opticalFlowMaxForwardBackwardError) {
+		YerFace_LogDebug4(logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " failed the optical flow forward-backward check (%.04lf).", output->faceId, output->frameNumber, worstError);
+		return false;
+	}
+
+	landmarks->resize(YERFACE_NUM_FACE_LANDMARKS);
+	for(size_t i = 0; i < forwardPoints.size(); i++) {
+		(*landmarks)[landmarkIndexes[i]] = Point2d(forwardPoints[i] + roiOffset) / searchFrameScaleFactor;
+	}
+	doParkUnpredictedLandmarks(landmarks);
+	return true;
+}
+
+void FaceTracker::doStoreFlowReference(Mat searchFrame, double searchFrameScaleFactor, FaceTrackerOutput *output, std::vector<Point2d> landmarks, double lastPredictionTimestamp) {
+	FaceTrackerFlowReference reference;
+	//Placeholders for landmarks the model doesn't predict are not worth tracking.
+	reference.landmarks.resize(landmarkIndexes.size());
+	for(size_t i = 0; i < landmarkIndexes.size(); i++) {
+		reference.landmarks[i] = Point2f(landmarks[landmarkIndexes[i]] * searchFrameScaleFactor);
+	}
+	reference.roi = Rect(Utilities::insetBox(Rect2d(boundingRect(reference.landmarks)), YERFACE_OPTICAL_FLOW_ROI_SCALE)) & Rect(0, 0, searchFrame.cols, searchFrame.rows);
+	if(reference.roi.area() <= 0) {
+		return;
+	}
+	cvtColor(searchFrame(reference.roi), reference.grayROI, COLOR_BGR2GRAY);
+	reference.searchFrameScaleFactor = searchFrameScaleFactor;
+	reference.timestamps = output->health.timestamps;
+	reference.lastPredictionTimestamp = lastPredictionTimestamp;
+	reference.set = true;
+
+	//Predictor workers finish out of order. Never replace a newer reference with an older one.
+	YerFace_MutexLock(myMutex);
+	auto referenceIterator = flowReferences.find(output->faceId);
+	if(referenceIterator == flowReferences.end() || referenceIterator->second.timestamps.frameNumber < output->frameNumber) {
+		flowReferences[output->faceId] = reference;
+	}
+	YerFace_MutexUnlock(myMutex);
+}
+
+bool FaceTracker::doPrepareAdaptiveLandmarkCrop(WorkingFrame *workingFrame, Rect2d searchRectNormalSize, Mat *crop, double *cropScaleFactor, Point2d *cropOffset) {
+	Mat frame = workingFrame->frame;
+	Rect roi = Rect(Utilities::insetBox(searchRectNormalSize, YERFACE_ADAPTIVE_CROP_ROI_SCALE)) & Rect(0, 0, frame.cols, frame.rows);
+	double estimatedInterOcularPixels = searchRectNormalSize.width * YERFACE_INTEROCULAR_TO_SEARCH_BOX_RATIO;
+	if(roi.area() <= 0 || estimatedInterOcularPixels <= 0.0) {
+		return false;
+	}
+	//Only ever shrink. Upsampling a small face costs more without adding any detail.
+	*cropScaleFactor = std::min(1.0, adaptiveLandmarkCropInterOcularPixels / estimatedInterOcularPixels);
+	*cropOffset = Point2d(roi.x, roi.y);
+	if(*cropScaleFactor < 1.0) {
+		resize(frame(roi), *crop, Size(), *cropScaleFactor, *cropScaleFactor, INTER_AREA);
+	} else {
+		*crop = frame(roi);
+	}
+	YerFace_LogDebug4(logger, "Frame #" YERFACE_FRAMENUMBER_FORMAT " predicting landmarks on a %dx%d crop (scale %.03lf).", workingFrame->frameTimestamps.frameNumber, crop->cols, crop->rows, *cropScaleFactor);
+	return true;
+}
+
+bool FaceTracker::getLandmarkBoxIsUsable(FacialTrackingBox box, FrameTimestamps frameTimestamps) {
+	return box.set && box.timestamps.frameNumber < frameTimestamps.frameNumber && frameTimestamps.startTimestamp - box.timestamps.startTimestamp <= landmarkBoxGoodForSeconds;
+}
+
 void FaceTracker::doIdentifyFeatures(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
 	FaceTrackerWorker *innerWorker = (FaceTrackerWorker *)worker->ptr;
 	FacialDetectionBox facialDetection = faceDetector->getFacialDetection(output->frameNumber);
-	if(!facialDetection.set) {
+	if(output->faceId < 0) {
 		return;
 	}
 
 	Mat searchFrame;
 	double searchFrameScaleFactor;
-	Rect2d searchRect;
 	if(useFullSizedFrameForLandmarkDetection) {
 		searchFrame = workingFrame->frame;
 		searchFrameScaleFactor = 1.0;
-		searchRect = facialDetection.boxNormalSize;
 	} else {
 		searchFrame = workingFrame->detectionFrame;
 		searchFrameScaleFactor = workingFrame->detectionScaleFactor;
-		searchRect = facialDetection.box;
 	}
 
-	dlib::cv_image<dlib::bgr_pixel> dlibSearchFrame = cv_image<bgr_pixel>(searchFrame);
-	dlib::rectangle dlibSearchBox = dlib::rectangle(searchRect.x, searchRect.y, (searchRect.width + searchRect.x), (searchRect.height + searchRect.y));
-
-	full_object_detection result = innerWorker->shapePredictor(dlibSearchFrame, dlibSearchBox);
+	//On a stable face, following the previous landmarks with optical flow is much cheaper than running the shape predictor.
+	std::vector<Point2d> landmarks;
+	Rect2d searchRectNormalSize;
+	double lastPredictionTimestamp = workingFrame->frameTimestamps.startTimestamp;
+	bool propagated = false;
+	if(opticalFlowEnabled) {
+		YerFace_MutexLock(myMutex);
+		FaceTrackerFlowReference reference;
+		reference.set = false;
+		auto referenceIterator = flowReferences.find(output->faceId);
+		if(referenceIterator != flowReferences.end()) {
+			reference = referenceIterator->second;
+		}
+		YerFace_MutexUnlock(myMutex);
+		if(getFlowReferenceIsUsable(reference, workingFrame->frameTimestamps) && workingFrame->frameTimestamps.startTimestamp - reference.lastPredictionTimestamp < opticalFlowFullPredictionIntervalSeconds) {
+			propagated = doPropagateLandmarks(searchFrame, searchFrameScaleFactor, output, reference, &landmarks);
+			if(propagated) {
+				lastPredictionTimestamp = reference.lastPredictionTimestamp;
+				YerFace_LogDebug4(logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " propagated landmarks from frame #" YERFACE_FRAMENUMBER_FORMAT, output->faceId, output->frameNumber, reference.timestamps.frameNumber);
+			}
+		}
+	}
 
-	output->facialFeatures.featuresExposed.features.clear();
-	output->facialFeatures.featuresExposed.features.resize(result.num_parts());
+	if(!propagated) {
+		//Prefer a box around recent landmarks over a (possibly stale) detection. The detector is only needed to initialize and recover.
+		bool useLandmarkBox = false;
+		if(landmarkBoxEnabled) {
+			YerFace_MutexLock(myMutex);
+			FacialTrackingBox previousLandmarkBox;
+			previousLandmarkBox.set = false;
+			auto landmarkBoxIterator = landmarkBoxes.find(output->faceId);
+			if(landmarkBoxIterator != landmarkBoxes.end()) {
+				previousLandmarkBox = landmarkBoxIterator->second;
+			}
+			YerFace_MutexUnlock(myMutex);
+			if(getLandmarkBoxIsUsable(previousLandmarkBox, workingFrame->frameTimestamps)) {
+				useLandmarkBox = true;
+				searchRectNormalSize = previousLandmarkBox.boxNormalSize;
+				YerFace_LogDebug4(logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " is searching within the landmarks of frame #" YERFACE_FRAMENUMBER_FORMAT, output->faceId, output->frameNumber, previousLandmarkBox.timestamps.frameNumber);
+			}
+		}
+		if(!useLandmarkBox) {
+			bool detectionFound = false;
+			for(FacialDetectionFace face : facialDetection.faces) {
+				if(face.faceId == output->faceId) {
+					searchRectNormalSize = face.boxNormalSize;
+					detectionFound = true;
+				}
+			}
+			if(!detectionFound) {
+				return;
+			}
+		}
 
-	output->facialFeatures.features.clear();
-	output->facialFeatures.features3D.clear();
-	DlibPointPointer partPointer;
-	dlib::point part;
-	Point2d partPoint;
-	for(unsigned long featureIndex = 0; featureIndex < result.num_parts(); featureIndex++) {
-		part = result.part(featureIndex);
-		partPointer.ptr = &part;
-		if(!doConvertLandmarkPointToImagePoint(partPointer, &partPoint, searchFrameScaleFactor)) {
+		//The shape predictor's cost and accuracy depend on how big the face is, not on how big the frame is.
+		Mat predictionFrame = searchFrame;
+		double predictionScaleFactor = searchFrameScaleFactor;
+		Point2d predictionOffset = Point2d(0.0, 0.0);
+		if(adaptiveLandmarkCropEnabled && !doPrepareAdaptiveLandmarkCrop(workingFrame, searchRectNormalSize, &predictionFrame, &predictionScaleFactor, &predictionOffset)) {
 			return;
 		}
+		Rect2d searchRect = Utilities::scaleRect(Rect2d(searchRectNormalSize.tl() - predictionOffset, searchRectNormalSize.size()), predictionScaleFactor);
 
-		output->facialFeatures.featuresExposed.features[featureIndex] = partPoint;
+		dlib::cv_image<dlib::bgr_pixel> dlibSearchFrame = cv_image<bgr_pixel>(predictionFrame);
+		dlib::rectangle dlibSearchBox = dlib::rectangle(searchRect.x, searchRect.y, (searchRect.width + searchRect.x), (searchRect.height + searchRect.y));
 
-		bool pushCorrelationPoint = false;
-		switch(featureIndex) {
-			case IDX_NOSE_SELLION:
-				output->facialFeatures.features3D.push_back(vertexNoseSellion);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_RIGHTEYE_OUTER_CORNER:
-				output->facialFeatures.features3D.push_back(vertexEyeRightOuterCorner);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_LEFTEYE_OUTER_CORNER:
-				output->facialFeatures.features3D.push_back(vertexEyeLeftOuterCorner);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_JAWLINE_0:
-				output->facialFeatures.features3D.push_back(vertexRightEar);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_JAWLINE_16:
-				output->facialFeatures.features3D.push_back(vertexLeftEar);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_NOSE_TIP:
-				output->facialFeatures.features3D.push_back(vertexNoseTip);
-				pushCorrelationPoint = true;
-				break;
-			case IDX_JAWLINE_8:
-				output->facialFeatures.features3D.push_back(vertexMenton);
-				pushCorrelationPoint = true;
-				break;
+		full_object_detection result = innerWorker->shapePredictor(dlibSearchFrame, dlibSearchBox);
+
+		//Gather all of the parts first, then map them back to frame coordinates in one tight loop.
+		size_t numParts = result.num_parts();
+		landmarks.resize(YERFACE_NUM_FACE_LANDMARKS);
+		for(size_t partIndex = 0; partIndex < numParts; partIndex++) {
+			const dlib::point &part = result.part(partIndex);
+			if(part == OBJECT_PART_NOT_PRESENT) {
+				return;
+			}
+			landmarks[landmarkIndexes[partIndex]] = Point2d(part.x(), part.y());
 		}
-		if(pushCorrelationPoint) {
-			output->facialFeatures.features.push_back(partPoint);
+		doParkUnpredictedLandmarks(&landmarks);
+		double inverseScaleFactor = 1.0 / predictionScaleFactor;
+		Point2d *landmarkData = landmarks.data();
+		for(size_t featureIndex = 0; featureIndex < YERFACE_NUM_FACE_LANDMARKS; featureIndex++) {
+			landmarkData[featureIndex].x = landmarkData[featureIndex].x * inverseScaleFactor + predictionOffset.x;
+			landmarkData[featureIndex].y = landmarkData[featureIndex].y * inverseScaleFactor + predictionOffset.y;
 		}
 	}
 
-	//Stommion needs a little extra help.
-	part = result.part(IDX_MOUTHIN_CENTER_TOP);
-	partPointer.ptr = &part;
-	Point2d mouthTop;
-	if(!doConvertLandmarkPointToImagePoint(partPointer, &mouthTop, searchFrameScaleFactor)) {
-		return;
+	if(opticalFlowEnabled) {
+		doStoreFlowReference(searchFrame, searchFrameScaleFactor, output, landmarks, lastPredictionTimestamp);
 	}
-	part = result.part(IDX_MOUTHIN_CENTER_BOTTOM);
-	partPointer.ptr = &part;
-	Point2d mouthBottom;
-	if(!doConvertLandmarkPointToImagePoint(partPointer, &mouthBottom, searchFrameScaleFactor)) {
-		return;
+
+	output->facialFeatures.featuresExposed.features = landmarks;
+
+	size_t numCorrelationLandmarks = correlationLandmarkIndexes.size();
+	output->facialFeatures.features.resize(numCorrelationLandmarks + 1);
+	for(size_t i = 0; i < numCorrelationLandmarks; i++) {
+		output->facialFeatures.features[i] = landmarks[correlationLandmarkIndexes[i]];
 	}
-	partPoint = (mouthTop + mouthTop + mouthBottom) / 3.0;
-	output->facialFeatures.features.push_back(partPoint);
-	output->facialFeatures.features3D.push_back(vertexStommion);
+
+	//Stommion needs a little extra help.
+	Point2d mouthTop = landmarks[IDX_MOUTHIN_CENTER_TOP];
+	Point2d mouthBottom = landmarks[IDX_MOUTHIN_CENTER_BOTTOM];
+	output->facialFeatures.features[numCorrelationLandmarks] = (mouthTop + mouthTop + mouthBottom) / 3.0;
+	output->facialFeatures.features3D = correlationVertices;
 	output->facialFeatures.set = true;
 	output->facialFeatures.featuresExposed.set = true;
+
+	//How far have the landmarks wandered from the detector's idea of the face? A large drift means the landmarks are going stale.
+	//  This is measured against the detector rather than the search box, because a search box seeded from landmarks would follow drift which feeds on itself.
+	output->health.landmarksSet = true;
+	output->health.boxDrift = 0.0;
+	for(FacialDetectionFace face : facialDetection.faces) {
+		if(face.faceId == output->faceId && face.boxNormalSize.width > 0.0) {
+			Rect2d landmarksBox = getDetectorStyleBoxFromLandmarks(landmarks);
+			output->health.boxDrift = Utilities::lineDistance(Utilities::centerRect(landmarksBox), Utilities::centerRect(face.boxNormalSize)) / face.boxNormalSize.width;
+		}
+	}
 }
 
 void FaceTracker::doInitializeCameraModel(WorkingFrame *workingFrame) {
@@ -303,157 +675,267 @@ void FaceTracker::doInitializeCameraModel(WorkingFrame *workingFrame) {
 
 	YerFace_MutexLock(myAssignmentMutex);
 	facialCameraModel.cameraMatrix = Utilities::generateFakeCameraMatrix(focalLength, center);
-	facialCameraModel.distortionCoefficients = Mat::zeros(4, 1, DataType<double>::type);
+	facialCameraModel.distortionCoefficients = Vec4d(0.0, 0.0, 0.0, 0.0);
 	facialCameraModel.set = true;
 	YerFace_MutexUnlock(myAssignmentMutex);
 }
 
-void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
+void FaceTracker::doSolveFacialPose(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
 	if(!output->facialFeatures.set) {
-		previouslyReportedFacialPose.set = false;
 		return;
 	}
 
-	FacialCameraModel camera = facialCameraModel;
-
-	FrameTimestamps frameTimestamps = workingFrame->frameTimestamps;
-	double frameTimestamp = frameTimestamps.startTimestamp;
 	FacialPose tempPose;
-	tempPose.timestamp = frameTimestamp;
+	tempPose.timestamp = workingFrame->frameTimestamps.startTimestamp;
 	tempPose.set = false;
-	Mat tempRotationVector;
+	Vec3d tempRotationVector;
+
+	//Pose changes very little from one frame to the next, so the last accepted solution is an excellent place to start.
+	bool useExtrinsicGuess = false;
+	YerFace_MutexLock(myAssignmentMutex);
+	if(!facialCameraModel.set) {
+		doInitializeCameraModel(workingFrame);
+	}
+	FacialCameraModel camera = facialCameraModel;
+	if(poseSolverWarmStart && poseSolverMethod == SOLVEPNP_ITERATIVE) {
+		auto stateIterator = faceStates.find(output->faceId);
+		if(stateIterator != faceStates.end() && stateIterator->second.poseSolverSeedSet) {
+			tempRotationVector = stateIterator->second.poseSolverSeedRotationVector;
+			tempPose.translationVector = stateIterator->second.poseSolverSeedTranslationVector;
+			useExtrinsicGuess = true;
+		}
+	}
+	YerFace_MutexUnlock(myAssignmentMutex);
 
 	//// DO FACIAL POSE SOLUTION ////
 
-	solvePnP(output->facialFeatures.features3D, output->facialFeatures.features, camera.cameraMatrix, camera.distortionCoefficients, tempRotationVector, tempPose.translationVector);
-	tempRotationVector.at<double>(0) = tempRotationVector.at<double>(0) * -1.0;
-	tempRotationVector.at<double>(1) = tempRotationVector.at<double>(1) * -1.0;
-	Rodrigues(tempRotationVector, tempPose.rotationMatrix);
+	solvePnP(output->facialFeatures.features3D, output->facialFeatures.features, camera.cameraMatrix, camera.distortionCoefficients, tempRotationVector, tempPose.translationVector, useExtrinsicGuess, poseSolverMethod);
+	if(poseSolverRefine) {
+		solvePnPRefineLM(output->facialFeatures.features3D, output->facialFeatures.features, camera.cameraMatrix, camera.distortionCoefficients, tempRotationVector, tempPose.translationVector);
+	}
+	output->solvedRotationVector = tempRotationVector;
+
+	//A rigid head model which doesn't fit the landmarks well suggests the shape predictor has lost the face.
+	std::vector<Point2d> reprojectedFeatures;
+	projectPoints(output->facialFeatures.features3D, tempRotationVector, tempPose.translationVector, camera.cameraMatrix, camera.distortionCoefficients, reprojectedFeatures);
+	double reprojectionError = 0.0;
+	for(size_t i = 0; i < reprojectedFeatures.size(); i++) {
+		reprojectionError += Utilities::lineDistance(reprojectedFeatures[i], output->facialFeatures.features[i]);
+	}
+	double faceWidth = getLandmarksBoundingBox(output->facialFeatures.featuresExposed.features).width;
+	if(reprojectedFeatures.size() > 0 && faceWidth > 0.0) {
+		output->health.reprojectionError = (reprojectionError / (double)reprojectedFeatures.size()) / faceWidth;
+	}
+
+	tempRotationVector[0] = tempRotationVector[0] * -1.0;
+	tempRotationVector[1] = tempRotationVector[1] * -1.0;
+	tempPose.rotationQuaternion = Utilities::rotationVectorToQuaternion(tempRotationVector);
+	tempPose.rotationMatrix = Utilities::quaternionToRotationMatrix(tempPose.rotationQuaternion);
 
-	//// REJECT BAD / OUT OF BOUNDS FACIAL POSES ////
+	//// REJECT OUT OF BOUNDS FACIAL POSES ////
 
-	bool reportNewPose = true;
+	output->solvedPoseInBounds = true;
+	if(tempPose.translationVector[0] < poseTranslationMinX || tempPose.translationVector[0] > poseTranslationMaxX ||
+	  tempPose.translationVector[1] < poseTranslationMinY || tempPose.translationVector[1] > poseTranslationMaxY ||
+	  tempPose.translationVector[2] < poseTranslationMinZ || tempPose.translationVector[2] > poseTranslationMaxZ) {
+		logger->info("Dropping facial pose due to out of bounds translation: <%.02f, %.02f, %.02f>", tempPose.translationVector[0], tempPose.translationVector[1], tempPose.translationVector[2]);
+		output->solvedPoseInBounds = false;
+	}
+	Vec3d angles = Utilities::rotationMatrixToEulerAngles(tempPose.rotationMatrix);
+
+	if(fabs(angles[0]) > poseRotationPlusMinusX || fabs(angles[1]) > poseRotationPlusMinusY || fabs(angles[2]) > poseRotationPlusMinusZ) {
+		logger->info("Dropping facial pose due to out of bounds angle: <%.02f, %.02f, %.02f>", angles[0], angles[1], angles[2]);
+		output->solvedPoseInBounds = false;
+	}
+
+	tempPose.set = true;
+	output->solvedPose = tempPose;
+}
+
+// One-Euro filter, as described by Casiez, Roussel & Vogel (CHI 2012).
+//  Slow landmarks get a low cutoff, which kills jitter. Fast landmarks get a high cutoff, which keeps lag down.
+void FaceTracker::doFilterLandmarks(WorkingFrame *workingFrame, FaceTrackerOutput *output) {
+	FaceTrackerFaceState *state = &faceStates[output->faceId];
+	if(!output->facialFeatures.featuresExposed.set) {
+		state->landmarkFilterSet = false;
+		return;
+	}
+
+	std::vector<Point2d> *landmarks = &output->facialFeatures.featuresExposed.features;
+	double frameTimestamp = workingFrame->frameTimestamps.startTimestamp;
+	double elapsed = frameTimestamp - state->landmarkFilterTimestamp;
+	if(!state->landmarkFilterSet || state->landmarkFilterValues.size() != landmarks->size() || elapsed <= 0.0) {
+		state->landmarkFilterValues = *landmarks;
+		state->landmarkFilterVelocities.assign(landmarks->size(), Point2d(0.0, 0.0));
+		state->landmarkFilterTimestamp = frameTimestamp;
+		state->landmarkFilterSet = true;
+		return;
+	}
+
+	//Speeds are measured in face widths per second, so the same beta works at any resolution.
+	double faceWidth = std::max(getLandmarksBoundingBox(*landmarks).width, 1.0);
+	double velocityAlpha = getLowPassAlpha(landmarkFilterDerivativeCutoff, elapsed);
+	for(int i : landmarkIndexes) {
+		Point2d velocity = ((*landmarks)[i] - state->landmarkFilterValues[i]) / elapsed;
+		state->landmarkFilterVelocities[i] += (velocity - state->landmarkFilterVelocities[i]) * velocityAlpha;
+		double cutoff = landmarkFilterMinCutoff + landmarkFilterBeta * (cv::norm(state->landmarkFilterVelocities[i]) / faceWidth);
+		state->landmarkFilterValues[i] += ((*landmarks)[i] - state->landmarkFilterValues[i]) * getLowPassAlpha(cutoff, elapsed);
+		(*landmarks)[i] = state->landmarkFilterValues[i];
+	}
+	state->landmarkFilterTimestamp = frameTimestamp;
+	//Placeholders follow the filtered nose tip rather than being filtered themselves.
+	doParkUnpredictedLandmarks(landmarks);
+}
+
+void FaceTracker::doParkUnpredictedLandmarks(std::vector<Point2d> *landmarks) {
+	//Landmarks a reduced model doesn't predict are parked on the nose tip, so they never widen a bounding box.
+	for(int featureIndex : unpredictedLandmarkIndexes) {
+		(*landmarks)[featureIndex] = (*landmarks)[IDX_NOSE_TIP];
+	}
+}
+
+void FaceTracker::doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
+	//Every face has its own smoothing and rejection history.
+	FaceTrackerFaceState *state = &faceStates[output->faceId];
+	state->lastSeenTimestamp = workingFrame->frameTimestamps.startTimestamp;
+
+	if(!output->facialFeatures.set || !output->solvedPose.set) {
+		state->previouslyReportedFacialPose.set = false;
+		state->poseSolverSeedSet = false;
+		return;
+	}
+
+	FrameTimestamps frameTimestamps = workingFrame->frameTimestamps;
+	double frameTimestamp = frameTimestamps.startTimestamp;
+	FacialPose tempPose = output->solvedPose;
+	tempPose.set = false;
+
+	//// REJECT BAD FACIAL POSES ////
+
+	bool reportNewPose = output->solvedPoseInBounds;
 	double degreesDifference, distance, scaledRotationThreshold, scaledTranslationThreshold;
 	double timeScale = (double)(frameTimestamps.estimatedEndTimestamp - frameTimestamps.startTimestamp) / (double)(1.0 / 30.0);
-	if(previouslyReportedFacialPose.set) {
+	if(state->previouslyReportedFacialPose.set) {
 		scaledRotationThreshold = poseRotationHighRejectionThreshold * timeScale;
 		scaledTranslationThreshold = poseTranslationHighRejectionThreshold * timeScale;
-		degreesDifference = Utilities::degreesDifferenceBetweenTwoRotationMatrices(previouslyReportedFacialPose.rotationMatrix, tempPose.rotationMatrix);
-		distance = Utilities::lineDistance(Point3d(tempPose.translationVector), Point3d(previouslyReportedFacialPose.translationVector));
+		degreesDifference = Utilities::degreesDifferenceBetweenTwoQuaternions(state->previouslyReportedFacialPose.rotationQuaternion, tempPose.rotationQuaternion);
+		distance = Utilities::lineDistance(Point3d(tempPose.translationVector), Point3d(state->previouslyReportedFacialPose.translationVector));
 		if(degreesDifference > scaledRotationThreshold || distance > scaledTranslationThreshold) {
 			logger->info("Dropping facial pose due to high rotation (%.02lf) or high motion (%.02lf)!", degreesDifference, distance);
 			reportNewPose = false;
 		}
 	}
-	if(tempPose.translationVector.at<double>(0) < poseTranslationMinX || tempPose.translationVector.at<double>(0) > poseTranslationMaxX ||
-	  tempPose.translationVector.at<double>(1) < poseTranslationMinY || tempPose.translationVector.at<double>(1) > poseTranslationMaxY ||
-	  tempPose.translationVector.at<double>(2) < poseTranslationMinZ || tempPose.translationVector.at<double>(2) > poseTranslationMaxZ) {
-		logger->info("Dropping facial pose due to out of bounds translation: <%.02f, %.02f, %.02f>", tempPose.translationVector.at<double>(0), tempPose.translationVector.at<double>(1), tempPose.translationVector.at<double>(2));
-		reportNewPose = false;
-	}
-	Vec3d angles = Utilities::rotationMatrixToEulerAngles(tempPose.rotationMatrix);
-
-	if(fabs(angles[0]) > poseRotationPlusMinusX || fabs(angles[1]) > poseRotationPlusMinusY || fabs(angles[2]) > poseRotationPlusMinusZ) {
-		logger->info("Dropping facial pose due to out of bounds angle: <%.02f, %.02f, %.02f>", angles[0], angles[1], angles[2]);
-		reportNewPose = false;
-	}
 	if(!reportNewPose) {
-		if(previouslyReportedFacialPose.set) {
-			if(tempPose.timestamp - previouslyReportedFacialPose.timestamp >= poseRejectionResetAfterSeconds) {
-				logger->notice("Facial pose has come back bad consistantly for %.02lf seconds! Unsetting the face pose completely.", tempPose.timestamp - previouslyReportedFacialPose.timestamp);
-				previouslyReportedFacialPose.set = false;
+		output->health.poseRejected = true;
+		if(state->previouslyReportedFacialPose.set) {
+			if(tempPose.timestamp - state->previouslyReportedFacialPose.timestamp >= poseRejectionResetAfterSeconds) {
+				logger->notice("Facial pose has come back bad consistantly for %.02lf seconds! Unsetting the face pose completely.", tempPose.timestamp - state->previouslyReportedFacialPose.timestamp);
+				state->previouslyReportedFacialPose.set = false;
 			}
-			output->facialPose = previouslyReportedFacialPose;
+			output->facialPose = state->previouslyReportedFacialPose;
 		} else {
 			output->facialPose.set = false;
 		}
+		//Don't seed the solver with a pose we wouldn't report. The next frame solves from scratch.
+		state->poseSolverSeedSet = false;
 		return;
 	}
+	state->poseSolverSeedRotationVector = output->solvedRotationVector;
+	state->poseSolverSeedTranslationVector = tempPose.translationVector;
+	state->poseSolverSeedSet = true;
 
 	//// DO FACIAL POSE SMOOTHING ////
 
-	facialPoseSmoothingBuffer.push_back(tempPose);
-	while(facialPoseSmoothingBuffer.front().timestamp <= (frameTimestamp - poseSmoothingOverSeconds)) {
-		facialPoseSmoothingBuffer.pop_front();
-	}
-
-	tempPose.translationVector = (Mat_<double>(3,1) << 0.0, 0.0, 0.0);
-	tempPose.rotationMatrix = (Mat_<double>(3,3) <<
-			0.0, 0.0, 0.0,
-			0.0, 0.0, 0.0,
-			0.0, 0.0, 0.0);
-
-	double combinedWeights = 0.0;
-	for(FacialPose pose : facialPoseSmoothingBuffer) {
-		double progress = (pose.timestamp - (frameTimestamp - poseSmoothingOverSeconds)) / poseSmoothingOverSeconds;
-		double weight = std::pow(progress, (double)poseSmoothingExponent) - combinedWeights;
-		combinedWeights += weight;
-		for(int j = 0; j < 3; j++) {
-			tempPose.translationVector.at<double>(j) += pose.translationVector.at<double>(j) * weight;
+	if(poseSmoothingRecursive) {
+		FacialPose *smoothedPose = &state->recursiveSmoothedPose;
+		if(!smoothedPose->set) {
+			*smoothedPose = tempPose;
+			smoothedPose->set = true;
+		} else {
+			double alpha = 1.0 - std::exp(-std::max(0.0, frameTimestamp - smoothedPose->timestamp) / poseSmoothingTimeConstant);
+			smoothedPose->translationVector += (tempPose.translationVector - smoothedPose->translationVector) * alpha;
+			smoothedPose->rotationQuaternion = Utilities::quaternionSlerp(smoothedPose->rotationQuaternion, tempPose.rotationQuaternion, alpha);
+			smoothedPose->timestamp = frameTimestamp;
+		}
+		tempPose.translationVector = smoothedPose->translationVector;
+		tempPose.rotationQuaternion = smoothedPose->rotationQuaternion;
+	} else {
+		state->facialPoseSmoothingBuffer.push_back(tempPose);
+		while(state->facialPoseSmoothingBuffer.front().timestamp <= (frameTimestamp - poseSmoothingOverSeconds)) {
+			state->facialPoseSmoothingBuffer.pop_front();
 		}
-		for(int j = 0; j < 9; j++) {
-			tempPose.rotationMatrix.at<double>(j) += pose.rotationMatrix.at<double>(j) * weight;
+
+		//Weighted nlerp: sum the quaternions on the same hemisphere as the newest one, then normalize.
+		Vec4d newestRotation = tempPose.rotationQuaternion;
+		tempPose.translationVector = Vec3d(0.0, 0.0, 0.0);
+		tempPose.rotationQuaternion = Vec4d(0.0, 0.0, 0.0, 0.0);
+
+		double combinedWeights = 0.0;
+		for(FacialPose pose : state->facialPoseSmoothingBuffer) {
+			double progress = (pose.timestamp - (frameTimestamp - poseSmoothingOverSeconds)) / poseSmoothingOverSeconds;
+			double weight = std::pow(progress, (double)poseSmoothingExponent) - combinedWeights;
+			combinedWeights += weight;
+			tempPose.translationVector += pose.translationVector * weight;
+			Vec4d rotation = pose.rotationQuaternion;
+			if(rotation.dot(newestRotation) < 0.0) {
+				rotation = -rotation;
+			}
+			tempPose.rotationQuaternion += rotation * weight;
 		}
+		tempPose.rotationQuaternion = cv::normalize(tempPose.rotationQuaternion);
 	}
+	tempPose.rotationMatrix = Utilities::quaternionToRotationMatrix(tempPose.rotationQuaternion);
 
 	tempPose.set = true;
-	angles = Utilities::rotationMatrixToEulerAngles(tempPose.rotationMatrix);
-	logger->debug3("Facial Pose Angle: <%.02f, %.02f, %.02f>; Translation: <%.02f, %.02f, %.02f>", angles[0], angles[1], angles[2], tempPose.translationVector.at<double>(0), tempPose.translationVector.at<double>(1), tempPose.translationVector.at<double>(2));
+	if(YerFace_LogSeverityEnabled(LOG_SEVERITY_DEBUG3)) {
+		Vec3d angles = Utilities::rotationMatrixToEulerAngles(tempPose.rotationMatrix);
+		logger->debug3("Facial Pose Angle: <%.02f, %.02f, %.02f>; Translation: <%.02f, %.02f, %.02f>", angles[0], angles[1], angles[2], tempPose.translationVector[0], tempPose.translationVector[1], tempPose.translationVector[2]);
+	}
 
 	//// REJECT NOISY SOLUTIONS ////
 
-	tempPose.rotationMatrixInternal = tempPose.rotationMatrix.clone();
-	tempPose.translationVectorInternal = tempPose.translationVector.clone();
-	if(previouslyReportedFacialPose.set) {
+	tempPose.rotationMatrixInternal = tempPose.rotationMatrix;
+	tempPose.rotationQuaternionInternal = tempPose.rotationQuaternion;
+	tempPose.translationVectorInternal = tempPose.translationVector;
+	if(state->previouslyReportedFacialPose.set) {
 		// Do de-noising (low motion rejection) first for the externally-facing matrices
 		scaledRotationThreshold = poseRotationLowRejectionThreshold * timeScale;
 		scaledTranslationThreshold = poseTranslationLowRejectionThreshold * timeScale;
 
-		degreesDifference = Utilities::degreesDifferenceBetweenTwoRotationMatrices(previouslyReportedFacialPose.rotationMatrix, tempPose.rotationMatrix);
+		degreesDifference = Utilities::degreesDifferenceBetweenTwoQuaternions(state->previouslyReportedFacialPose.rotationQuaternion, tempPose.rotationQuaternion);
 		if(degreesDifference < scaledRotationThreshold) {
-			tempPose.rotationMatrix = previouslyReportedFacialPose.rotationMatrix.clone();
+			tempPose.rotationMatrix = state->previouslyReportedFacialPose.rotationMatrix;
+			tempPose.rotationQuaternion = state->previouslyReportedFacialPose.rotationQuaternion;
 		}
-		distance = Utilities::lineDistance(Point3d(tempPose.translationVector), Point3d(previouslyReportedFacialPose.translationVector));
+		distance = Utilities::lineDistance(Point3d(tempPose.translationVector), Point3d(state->previouslyReportedFacialPose.translationVector));
 		if(distance < scaledTranslationThreshold) {
-			tempPose.translationVector = previouslyReportedFacialPose.translationVector.clone();
+			tempPose.translationVector = state->previouslyReportedFacialPose.translationVector;
 		}
 
 		// Do de-noising (low motion rejection) again, but for the internally-facing matrices
 		scaledRotationThreshold = poseRotationLowRejectionThresholdInternal * timeScale;
 		scaledTranslationThreshold = poseTranslationLowRejectionThresholdInternal * timeScale;
 
-		degreesDifference = Utilities::degreesDifferenceBetweenTwoRotationMatrices(previouslyReportedFacialPose.rotationMatrixInternal, tempPose.rotationMatrixInternal);
+		degreesDifference = Utilities::degreesDifferenceBetweenTwoQuaternions(state->previouslyReportedFacialPose.rotationQuaternionInternal, tempPose.rotationQuaternionInternal);
 		if(degreesDifference < scaledRotationThreshold) {
-			tempPose.rotationMatrixInternal = previouslyReportedFacialPose.rotationMatrixInternal.clone();
+			tempPose.rotationMatrixInternal = state->previouslyReportedFacialPose.rotationMatrixInternal;
+			tempPose.rotationQuaternionInternal = state->previouslyReportedFacialPose.rotationQuaternionInternal;
 		}
-		distance = Utilities::lineDistance(Point3d(tempPose.translationVectorInternal), Point3d(previouslyReportedFacialPose.translationVectorInternal));
+		distance = Utilities::lineDistance(Point3d(tempPose.translationVectorInternal), Point3d(state->previouslyReportedFacialPose.translationVectorInternal));
 		if(distance < scaledTranslationThreshold) {
-			tempPose.translationVectorInternal = previouslyReportedFacialPose.translationVectorInternal.clone();
+			tempPose.translationVectorInternal = state->previouslyReportedFacialPose.translationVectorInternal;
 		}
 	}
 
 	output->facialPose = tempPose;
-	previouslyReportedFacialPose = output->facialPose;
+	state->previouslyReportedFacialPose = output->facialPose;
 }
 
 void FaceTracker::doPrecalculateFacialPlaneNormal(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output) {
 	if(!output->facialPose.set) {
 		return;
 	}
-	Mat planeNormalMat = (Mat_<double>(3, 1) << 0.0, 0.0, -1.0);
-	planeNormalMat = output->facialPose.rotationMatrixInternal * planeNormalMat;
-	output->facialPose.facialPlaneNormal = Vec3d(planeNormalMat.at<double>(0), planeNormalMat.at<double>(1), planeNormalMat.at<double>(2));
-}
-
-bool FaceTracker::doConvertLandmarkPointToImagePoint(DlibPointPointer pointPointer, Point2d *dst, double detectionScaleFactor) {
-	dlib::point *src = pointPointer.ptr;
-	if(*src == OBJECT_PART_NOT_PRESENT) {
-		return false;
-	}
-	*dst = Point2d(src->x(), src->y());
-	dst->x /= detectionScaleFactor;
-	dst->y /= detectionScaleFactor;
-	return true;
+	output->facialPose.facialPlaneNormal = output->facialPose.rotationMatrixInternal * Vec3d(0.0, 0.0, -1.0);
 }
 
 void FaceTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int density, bool mirrorMode) {
@@ -462,7 +944,7 @@ void FaceTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int densi
 		YerFace_MutexUnlock(myMutex);
 		throw invalid_argument("FaceTracker::renderPreviewHUD() passed invalid frame number");
 	}
-	FaceTrackerOutput output = outputFrames[frameNumber];
+	std::vector<FaceTrackerOutput> faces = outputFrames[frameNumber].faces;
 	YerFace_MutexUnlock(myMutex);
 
 	YerFace_MutexLock(myAssignmentMutex);
@@ -471,86 +953,116 @@ void FaceTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int densi
 
 	int frameWidth = frame.size().width;
 
-	if(density > 0) {
-		if(output.facialPose.set) {
-			std::vector<Point3d> gizmo3d(6);
-			std::vector<Point2d> gizmo2d;
-			gizmo3d[0] = Point3d(-50,0.0,0.0);
-			gizmo3d[1] = Point3d(50,0.0,0.0);
-			gizmo3d[2] = Point3d(0.0,50,0.0);
-			gizmo3d[3] = Point3d(0.0,-50,0.0);
-			gizmo3d[4] = Point3d(0.0,0.0,50);
-			gizmo3d[5] = Point3d(0.0,0.0,-50);
+	for(FaceTrackerOutput output : faces) {
+		if(density > 0) {
+			if(output.facialPose.set) {
+				std::vector<Point3d> gizmo3d(6);
+				std::vector<Point2d> gizmo2d;
+				gizmo3d[0] = Point3d(-50,0.0,0.0);
+				gizmo3d[1] = Point3d(50,0.0,0.0);
+				gizmo3d[2] = Point3d(0.0,50,0.0);
+				gizmo3d[3] = Point3d(0.0,-50,0.0);
+				gizmo3d[4] = Point3d(0.0,0.0,50);
+				gizmo3d[5] = Point3d(0.0,0.0,-50);
 			
-			Mat tempRotationVector;
-			Rodrigues(output.facialPose.rotationMatrix, tempRotationVector);
-			projectPoints(gizmo3d, tempRotationVector, output.facialPose.translationVector, camera.cameraMatrix, camera.distortionCoefficients, gizmo2d);
-			if(mirrorMode) {
-				for(int i = 0; i <= 5; i++) {
-					gizmo2d[i].x = frameWidth - gizmo2d[i].x;
+				Vec3d tempRotationVector;
+				Rodrigues(output.facialPose.rotationMatrix, tempRotationVector);
+				projectPoints(gizmo3d, tempRotationVector, output.facialPose.translationVector, camera.cameraMatrix, camera.distortionCoefficients, gizmo2d);
+				if(mirrorMode) {
+					for(int i = 0; i <= 5; i++) {
+						gizmo2d[i].x = frameWidth - gizmo2d[i].x;
+					}
 				}
+				arrowedLine(frame, gizmo2d[0], gizmo2d[1], Scalar(0, 0, 255), 2, LINE_AA); // FIXME - proportional drawing size
+				arrowedLine(frame, gizmo2d[2], gizmo2d[3], Scalar(255, 0, 0), 2, LINE_AA); // FIXME - proportional drawing size
+				arrowedLine(frame, gizmo2d[4], gizmo2d[5], Scalar(0, 255, 0), 2, LINE_AA); // FIXME - proportional drawing size
 			}
-			arrowedLine(frame, gizmo2d[0], gizmo2d[1], Scalar(0, 0, 255), 2, LINE_AA); // FIXME - proportional drawing size
-			arrowedLine(frame, gizmo2d[2], gizmo2d[3], Scalar(255, 0, 0), 2, LINE_AA); // FIXME - proportional drawing size
-			arrowedLine(frame, gizmo2d[4], gizmo2d[5], Scalar(0, 255, 0), 2, LINE_AA); // FIXME - proportional drawing size
 		}
-	}
-	if(density > 3) {
-		if(output.facialFeatures.set) {
-			for(Point2d feature : output.facialFeatures.featuresExposed.features) {
-				if(mirrorMode) {
-					feature.x = frameWidth - feature.x;
+		if(density > 3) {
+			if(output.facialFeatures.set) {
+				for(size_t featureIndex = 0; featureIndex < output.facialFeatures.featuresExposed.features.size(); featureIndex++) {
+					if(!landmarkPredicted[featureIndex]) {
+						continue;
+					}
+					Point2d feature = output.facialFeatures.featuresExposed.features[featureIndex];
+					if(mirrorMode) {
+						feature.x = frameWidth - feature.x;
+					}
+					Utilities::drawX(frame, feature, Scalar(147, 20, 255)); // FIXME - proportional drawing
 				}
-				Utilities::drawX(frame, feature, Scalar(147, 20, 255)); // FIXME - proportional drawing
 			}
 		}
-	}
 
-	if(density > 4) {
-		if(output.facialPose.set) {
-			std::vector<Point3d> edges3d;
-			std::vector<Point2d> edges2d;
-
-			std::list<double> depths = { depthSliceA, depthSliceB, depthSliceC, depthSliceD, depthSliceE, depthSliceF, depthSliceG };
-			for(double depth : depths) {
-				double planeWidth = 300;
-				double gridIncrement = 25;
-				double planeEdge = (planeWidth / 2.0);
-				for(double x = planeEdge * -1.0; x <= planeEdge; x = x + gridIncrement) {
-					edges3d.push_back(Point3d(x, planeEdge, depth));
-					edges3d.push_back(Point3d(x, planeEdge * -1.0, depth));
-				}
-				for(double y = planeEdge * -1.0; y <= planeEdge; y = y + gridIncrement) {
-					edges3d.push_back(Point3d(planeEdge, y, depth));
-					edges3d.push_back(Point3d(planeEdge * -1.0, y, depth));
+		if(density > 4) {
+			if(output.facialPose.set) {
+				std::vector<Point3d> edges3d;
+				std::vector<Point2d> edges2d;
+
+				const double depths[] = { depthSliceA, depthSliceB, depthSliceC, depthSliceD, depthSliceE, depthSliceF, depthSliceG };
+				for(double depth : depths) {
+					double planeWidth = 300;
+					double gridIncrement = 25;
+					double planeEdge = (planeWidth / 2.0);
+					for(double x = planeEdge * -1.0; x <= planeEdge; x = x + gridIncrement) {
+						edges3d.push_back(Point3d(x, planeEdge, depth));
+						edges3d.push_back(Point3d(x, planeEdge * -1.0, depth));
+					}
+					for(double y = planeEdge * -1.0; y <= planeEdge; y = y + gridIncrement) {
+						edges3d.push_back(Point3d(planeEdge, y, depth));
+						edges3d.push_back(Point3d(planeEdge * -1.0, y, depth));
+					}
 				}
-			}
 
-			projectPoints(edges3d, output.facialPose.rotationMatrix, output.facialPose.translationVector, camera.cameraMatrix, camera.distortionCoefficients, edges2d);
+				projectPoints(edges3d, output.facialPose.rotationMatrix, output.facialPose.translationVector, camera.cameraMatrix, camera.distortionCoefficients, edges2d);
 
-			for(unsigned int i = 0; i + 1 < edges2d.size(); i = i + 2) {
-				if(mirrorMode) {
-					edges2d[i].x = frameWidth - edges2d[i].x;
-					edges2d[i + 1].x = frameWidth - edges2d[i + 1].x;
+				for(unsigned int i = 0; i + 1 < edges2d.size(); i = i + 2) {
+					if(mirrorMode) {
+						edges2d[i].x = frameWidth - edges2d[i].x;
+						edges2d[i + 1].x = frameWidth - edges2d[i + 1].x;
+					}
+					cv::line(frame, edges2d[i], edges2d[i + 1], Scalar(255, 255, 255), 1, LINE_AA); // FIXME - proportional drawing
 				}
-				cv::line(frame, edges2d[i], edges2d[i + 1], Scalar(255, 255, 255), 1, LINE_AA); // FIXME - proportional drawing
 			}
 		}
 	}
 }
 
-FacialFeatures FaceTracker::getFacialFeatures(FrameNumber frameNumber) {
-	FacialFeatures val;
+FaceTrackerOutput FaceTracker::getFaceTrackerOutput(FrameNumber frameNumber, size_t faceIndex, const char *caller) {
+	YerFace_MutexLock(myMutex);
+	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
+		YerFace_MutexUnlock(myMutex);
+		throw invalid_argument(string("FaceTracker::") + caller + "() passed invalid frame number");
+	}
+	FaceTrackerFrameOutput *frameOutput = &outputFrames[frameNumber];
+	if(faceIndex >= frameOutput->faces.size()) {
+		YerFace_MutexUnlock(myMutex);
+		throw invalid_argument(string("FaceTracker::") + caller + "() passed invalid face index");
+	}
+	FaceTrackerOutput val = frameOutput->faces[faceIndex];
+	YerFace_MutexUnlock(myMutex);
+	return val;
+}
+
+size_t FaceTracker::getNumFaces(FrameNumber frameNumber) {
+	size_t val;
 	YerFace_MutexLock(myMutex);
 	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
 		YerFace_MutexUnlock(myMutex);
-		throw invalid_argument("FaceTracker::getFacialFeatures() passed invalid frame number");
+		throw invalid_argument("FaceTracker::getNumFaces() passed invalid frame number");
 	}
-	val = outputFrames[frameNumber].facialFeatures.featuresExposed;
+	val = outputFrames[frameNumber].faces.size();
 	YerFace_MutexUnlock(myMutex);
 	return val;
 }
 
+int FaceTracker::getFaceId(FrameNumber frameNumber, size_t faceIndex) {
+	return getFaceTrackerOutput(frameNumber, faceIndex, "getFaceId").faceId;
+}
+
+FacialFeatures FaceTracker::getFacialFeatures(FrameNumber frameNumber, size_t faceIndex) {
+	return getFaceTrackerOutput(frameNumber, faceIndex, "getFacialFeatures").facialFeatures.featuresExposed;
+}
+
 FacialCameraModel FaceTracker::getFacialCameraModel(void) {
 	FacialCameraModel val;
 	YerFace_MutexLock(myAssignmentMutex);
@@ -559,97 +1071,59 @@ FacialCameraModel FaceTracker::getFacialCameraModel(void) {
 	return val;
 }
 
-FacialPose FaceTracker::getFacialPose(FrameNumber frameNumber) {
-	FacialPose val;
-	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
-		YerFace_MutexUnlock(myMutex);
-		throw invalid_argument("FaceTracker::getFacialPose() passed invalid frame number");
-	}
-	val = outputFrames[frameNumber].facialPose;
-	YerFace_MutexUnlock(myMutex);
-	return val;
+FacialPose FaceTracker::getFacialPose(FrameNumber frameNumber, size_t faceIndex) {
+	return getFaceTrackerOutput(frameNumber, faceIndex, "getFacialPose").facialPose;
 }
 
-FacialPlane FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType) {
-	FacialPose facialPose;
-	YerFace_MutexLock(myMutex);
-	if(frameNumber < 0 || outputFrames.find(frameNumber) == outputFrames.end()) {
-		YerFace_MutexUnlock(myMutex);
-		throw invalid_argument("FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose() passed invalid frame number");
-	}
-	facialPose = outputFrames[frameNumber].facialPose;
-	YerFace_MutexUnlock(myMutex);
+FacialPlane FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType, size_t faceIndex) {
+	FacialPose facialPose = getFaceTrackerOutput(frameNumber, faceIndex, "getCalculatedFacialPlaneForWorkingFacialPose").facialPose;
 
 	if(!facialPose.set) {
 		throw runtime_error("Can't do FaceTracker::getCalculatedFacialPlaneForWorkingFacialPose() when no working FacialPose is set.");
 	}
 
-	double depth = 0;
-	switch(markerType.type) {
-		default:
-			throw runtime_error("Unsupported MarkerType!");
-		case EyelidLeftTop:
-		case EyelidLeftBottom:
-		case EyelidRightTop:
-		case EyelidRightBottom:
-			depth = depthSliceG;
-			break;
-		case EyebrowLeftInner:
-		case EyebrowRightInner:
-			depth = depthSliceE;
-			break;
-		case EyebrowLeftMiddle:
-		case EyebrowRightMiddle:
-			depth = depthSliceF;
-			break;
-		case EyebrowLeftOuter:
-		case EyebrowRightOuter:
-			depth = depthSliceH;
-			break;
-		case LipsLeftCorner:
-		case LipsRightCorner:
-			depth = depthSliceD;
-			break;
-		case LipsLeftTop:
-		case LipsRightTop:
-			depth = depthSliceC;
-			break;
-		case LipsLeftBottom:
-		case LipsRightBottom:
-			depth = depthSliceB;
-			break;
-		case Jaw:
-			depth = depthSliceA;
-			break;
+	if(markerType.type < 0 || markerType.type >= NoMarkerAssigned) {
+		throw runtime_error("Unsupported MarkerType!");
 	}
+	double depth = markerTypeDepths[markerType.type];
 
-	Mat translationOffset = (Mat_<double>(3,1) << 0.0, 0.0, depth);
-	translationOffset = facialPose.rotationMatrixInternal * translationOffset;
+	Vec3d translationOffset = facialPose.rotationMatrixInternal * Vec3d(0.0, 0.0, depth);
 
 	FacialPlane facialPlane;
-	Mat translationVector = facialPose.translationVectorInternal + translationOffset;
-	facialPlane.planePoint = Point3d(translationVector.at<double>(0), translationVector.at<double>(1), translationVector.at<double>(2));
+	facialPlane.planePoint = Point3d(facialPose.translationVectorInternal + translationOffset);
 	facialPlane.planeNormal = facialPose.facialPlaneNormal;
 
 	return facialPlane;
 }
 
+void FaceTracker::handleFrameServerStallEvent(void *userdata) {
+	FaceTracker *self = (FaceTracker *)userdata;
+	YerFace_MutexLock(self->myMutex);
+	size_t predictionDepth = self->pendingPredictions.size();
+	size_t outputDepth = self->outputFrames.size();
+	YerFace_MutexUnlock(self->myMutex);
+	YerFace_MutexLock(self->myAssignmentMutex);
+	size_t assignmentDepth = self->pendingAssignmentFrameNumbers.size();
+	YerFace_MutexUnlock(self->myAssignmentMutex);
+	self->logger->warning("... Queue depths: <Pending Predictions: %lu, Pending Assignments: %lu, Output Frames: %lu>", predictionDepth, assignmentDepth, outputDepth);
+}
+
 void FaceTracker::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
 	FaceTracker *self = (FaceTracker *)userdata;
-	FaceTrackerOutput output;
+	FaceTrackerFrameOutput frameOutput;
 	FaceTrackerAssignmentTask assignment;
+	FacialDetectionBox facialDetection;
+	std::vector<int> faceIds;
 	switch(newStatus) {
 		default:
 			throw logic_error("Handler passed unsupported frame status change event!");
 		case FRAME_STATUS_NEW:
-			output.set = false;
-			output.facialFeatures.set = false;
-			output.facialFeatures.featuresExposed.set = false;
-			output.facialPose.set = false;
+			frameOutput.faces.resize(1);
+			self->doInitializeOutput(&frameOutput.faces[0], frameTimestamps, -1);
+			frameOutput.predictionsPending = 0;
 			YerFace_MutexLock(self->myMutex);
-			self->outputFrames[frameNumber] = output;
+			self->outputFrames[frameNumber] = frameOutput;
 			YerFace_MutexUnlock(self->myMutex);
 			assignment.frameNumber = frameNumber;
 			assignment.readyForAssignment = false;
@@ -658,9 +1132,55 @@ void FaceTracker::handleFrameStatusChange(void *userdata, WorkingFrameStatus new
 			YerFace_MutexUnlock(self->myAssignmentMutex);
 			break;
 		case FRAME_STATUS_TRACKING:
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->pendingPredictionFrameNumbers.size());
+			//One prediction per face. Faces come from the detector, plus any face we are still following by its landmarks.
+			facialDetection = self->faceDetector->getFacialDetection(frameNumber);
+			for(FacialDetectionFace face : facialDetection.faces) {
+				faceIds.push_back(face.faceId);
+			}
 			YerFace_MutexLock(self->myMutex);
-			self->pendingPredictionFrameNumbers.push_back(frameNumber);
+			if(self->landmarkBoxEnabled) {
+				for(auto landmarkBoxPair : self->landmarkBoxes) {
+					if((int)faceIds.size() >= self->faceDetector->getMaxFaces()) {
+						break;
+					}
+					if(std::find(faceIds.begin(), faceIds.end(), landmarkBoxPair.first) == faceIds.end() && self->getLandmarkBoxIsUsable(landmarkBoxPair.second, frameTimestamps)) {
+						//If the detector found this face under another ID, following it here too would track one person twice.
+						if(self->getBoxIsDetectedFace(landmarkBoxPair.second.boxNormalSize, facialDetection)) {
+							YerFace_LogDebug4(self->logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " overlaps a detected face. Dropping its landmark box.", landmarkBoxPair.first, frameNumber);
+							continue;
+						}
+						faceIds.push_back(landmarkBoxPair.first);
+					}
+				}
+			}
+			if(self->opticalFlowEnabled) {
+				for(auto referencePair : self->flowReferences) {
+					if((int)faceIds.size() >= self->faceDetector->getMaxFaces()) {
+						break;
+					}
+					if(std::find(faceIds.begin(), faceIds.end(), referencePair.first) == faceIds.end() && self->getFlowReferenceIsUsable(referencePair.second, frameTimestamps)) {
+						if(self->getBoxIsDetectedFace(self->getFlowReferenceBox(referencePair.second), facialDetection)) {
+							YerFace_LogDebug4(self->logger, "Face #%d on frame #" YERFACE_FRAMENUMBER_FORMAT " overlaps a detected face. Dropping its flow reference.", referencePair.first, frameNumber);
+							continue;
+						}
+						faceIds.push_back(referencePair.first);
+					}
+				}
+			}
+			if(faceIds.size() == 0) {
+				faceIds.push_back(-1);
+			}
+			frameOutput.faces.resize(faceIds.size());
+			for(size_t i = 0; i < faceIds.size(); i++) {
+				self->doInitializeOutput(&frameOutput.faces[i], frameTimestamps, faceIds[i]);
+				FaceTrackerPredictionTask task;
+				task.frameNumber = frameNumber;
+				task.faceIndex = i;
+				self->pendingPredictions.push_back(task);
+			}
+			frameOutput.predictionsPending = faceIds.size();
+			self->outputFrames[frameNumber] = frameOutput;
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me with %lu faces. Queue depth is now %lu", frameNumber, faceIds.size(), self->pendingPredictions.size());
 			YerFace_MutexUnlock(self->myMutex);
 			if(self->predictorWorkerPool != NULL) {
 				self->predictorWorkerPool->sendWorkerSignal();
@@ -679,6 +1199,9 @@ void FaceTracker::predictorWorkerInitializer(WorkerPoolWorker *worker, void *ptr
 	FaceTrackerWorker *innerWorker = new FaceTrackerWorker();
 	innerWorker->self = self;
 	deserialize(self->featureDetectionModelFileName.c_str()) >> innerWorker->shapePredictor;
+	if(innerWorker->shapePredictor.num_parts() != self->landmarkIndexes.size()) {
+		throw runtime_error("dlibFaceLandmarks model predicts " + to_string(innerWorker->shapePredictor.num_parts()) + " landmarks, but dlibFaceLandmarksIndexes describes " + to_string(self->landmarkIndexes.size()) + ".");
+	}
 	worker->ptr = (void *)innerWorker;
 }
 
@@ -688,12 +1211,16 @@ bool FaceTracker::predictorWorkerHandler(WorkerPoolWorker *worker) {
 
 	bool didWork = false;
 	FrameNumber myFrameNumber = -1;
+	size_t myFaceIndex = 0;
+	FaceTrackerOutput output;
 
 	YerFace_MutexLock(self->myMutex);
 	//// CHECK FOR WORK ////
-	if(self->pendingPredictionFrameNumbers.size() > 0) {
-		myFrameNumber = self->pendingPredictionFrameNumbers.front();
-		self->pendingPredictionFrameNumbers.pop_front();
+	if(self->pendingPredictions.size() > 0) {
+		myFrameNumber = self->pendingPredictions.front().frameNumber;
+		myFaceIndex = self->pendingPredictions.front().faceIndex;
+		self->pendingPredictions.pop_front();
+		output = self->outputFrames[myFrameNumber].faces[myFaceIndex];
 	}
 	YerFace_MutexUnlock(self->myMutex);
 
@@ -703,24 +1230,24 @@ bool FaceTracker::predictorWorkerHandler(WorkerPoolWorker *worker) {
 
 		WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(myFrameNumber);
 
-		FaceTrackerOutput output;
-		output.set = false;
-		output.facialFeatures.set = false;
-		output.facialFeatures.featuresExposed.set = false;
-		output.facialPose.set = false;
-		output.frameNumber = myFrameNumber;
-
 		self->doIdentifyFeatures(worker, workingFrame, &output);
+		self->doSolveFacialPose(worker, workingFrame, &output);
 
+		//The frame is ready for assignment once every one of its faces has been predicted.
 		YerFace_MutexLock(self->myMutex);
-		self->outputFrames[myFrameNumber] = output;
+		FaceTrackerFrameOutput *frameOutput = &self->outputFrames[myFrameNumber];
+		frameOutput->faces[myFaceIndex] = output;
+		frameOutput->predictionsPending--;
+		bool frameReady = frameOutput->predictionsPending == 0;
 		YerFace_MutexUnlock(self->myMutex);
 
-		YerFace_MutexLock(self->myAssignmentMutex);
-		self->pendingAssignmentFrameNumbers[myFrameNumber].readyForAssignment = true;
-		YerFace_MutexUnlock(self->myAssignmentMutex);
-		if(self->assignmentWorkerPool != NULL) {
-			self->assignmentWorkerPool->sendWorkerSignal();
+		if(frameReady) {
+			YerFace_MutexLock(self->myAssignmentMutex);
+			self->pendingAssignmentFrameNumbers[myFrameNumber].readyForAssignment = true;
+			YerFace_MutexUnlock(self->myAssignmentMutex);
+			if(self->assignmentWorkerPool != NULL) {
+				self->assignmentWorkerPool->sendWorkerSignal();
+			}
 		}
 
 		self->metricsPredictor->endClock(tick);
@@ -745,7 +1272,7 @@ bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 		}
 	}
 	if(myFrameNumber > 0 && !self->pendingAssignmentFrameNumbers[myFrameNumber].readyForAssignment) {
-		self->logger->debug4("BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
+		YerFace_LogDebug4(self->logger, "BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 		myFrameNumber = -1;
 	}
 	if(myFrameNumber > 0) {
@@ -754,15 +1281,15 @@ bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 	YerFace_MutexUnlock(self->myAssignmentMutex);
 
 	YerFace_MutexLock(self->myMutex);
-	FaceTrackerOutput output;
+	FaceTrackerFrameOutput frameOutput;
 	if(myFrameNumber > 0) {
-		output = self->outputFrames[myFrameNumber];
+		frameOutput = self->outputFrames[myFrameNumber];
 	}
 	YerFace_MutexUnlock(self->myMutex);
 
 	//// DO THE WORK ////
 	if(myFrameNumber > 0) {
-		self->logger->debug4("Face Tracker Assignment Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
+		YerFace_LogDebug4(self->logger, "Face Tracker Assignment Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 		if(myFrameNumber <= lastFrameNumber) {
 			throw logic_error("FaceTracker handling frames out of order!");
 		}
@@ -773,15 +1300,86 @@ bool FaceTracker::assignmentWorkerHandler(WorkerPoolWorker *worker) {
 		WorkingFrame *workingFrame = self->frameServer->getWorkingFrame(myFrameNumber);
 		
 		YerFace_MutexLock(self->myAssignmentMutex);
-		if(!self->facialCameraModel.set) {
-			self->doInitializeCameraModel(workingFrame);
+		MetricsTick transformationTick = self->metricsTransformation->startClock();
+		for(FaceTrackerOutput &output : frameOutput.faces) {
+			if(output.faceId >= 0) {
+				if(self->landmarkFilterEnabled) {
+					self->doFilterLandmarks(workingFrame, &output);
+				}
+				self->doCalculateFacialTransformation(worker, workingFrame, &output);
+				self->doPrecalculateFacialPlaneNormal(worker, workingFrame, &output);
+			}
+		}
+		resetAbsentFaceStates(&self->faceStates, frameOutput.faces);
+		self->metricsTransformation->endClock(transformationTick);
+
+		//Forget the smoothing history of faces which have been gone long enough that it would be thrown away anyway.
+		double frameStartTimestamp = workingFrame->frameTimestamps.startTimestamp;
+		for(auto iterator = self->faceStates.begin(); iterator != self->faceStates.end();) {
+			if(frameStartTimestamp - iterator->second.lastSeenTimestamp > self->poseSmoothingOverSeconds + self->poseRejectionResetAfterSeconds) {
+				iterator = self->faceStates.erase(iterator);
+			} else {
+				++iterator;
+			}
 		}
-		self->doCalculateFacialTransformation(worker, workingFrame, &output);
-		self->doPrecalculateFacialPlaneNormal(worker, workingFrame, &output);
 		YerFace_MutexUnlock(self->myAssignmentMutex);
 
+		//The detector gets one report per frame: the first unhealthy face if there is one, otherwise the primary face.
+		FaceTrackingHealth reportedHealth = frameOutput.faces[0].health;
+		for(FaceTrackerOutput output : frameOutput.faces) {
+			if(!self->faceDetector->getTrackingHealthIsGood(output.health)) {
+				reportedHealth = output.health;
+				break;
+			}
+		}
+		self->faceDetector->reportTrackingHealth(reportedHealth);
+		//Faces we are following by their landmarks must not be forgotten by the detector, or a re-detection would give them a second ID.
+		for(FaceTrackerOutput output : frameOutput.faces) {
+			if(output.faceId >= 0 && self->faceDetector->getTrackingHealthIsGood(output.health) && output.facialFeatures.featuresExposed.set) {
+				self->faceDetector->reportTrackedFace(output.faceId, getDetectorStyleBoxFromLandmarks(output.facialFeatures.featuresExposed.features), output.health.timestamps);
+			}
+		}
+
 		YerFace_MutexLock(self->myMutex);
-		self->outputFrames[myFrameNumber] = output;
+		if(self->landmarkBoxEnabled) {
+			//Only landmarks we trust get to seed the next search. Otherwise we fall back to the detector.
+			for(FaceTrackerOutput output : frameOutput.faces) {
+				if(output.faceId < 0) {
+					continue;
+				}
+				if(self->faceDetector->getTrackingHealthIsGood(output.health) && output.facialFeatures.featuresExposed.set) {
+					FacialTrackingBox *landmarkBox = &self->landmarkBoxes[output.faceId];
+					landmarkBox->boxNormalSize = getDetectorStyleBoxFromLandmarks(output.facialFeatures.featuresExposed.features);
+					landmarkBox->timestamps = output.health.timestamps;
+					landmarkBox->set = true;
+				} else {
+					self->landmarkBoxes.erase(output.faceId);
+				}
+			}
+			for(auto iterator = self->landmarkBoxes.begin(); iterator != self->landmarkBoxes.end();) {
+				if(frameStartTimestamp - iterator->second.timestamps.startTimestamp > self->landmarkBoxGoodForSeconds) {
+					iterator = self->landmarkBoxes.erase(iterator);
+				} else {
+					++iterator;
+				}
+			}
+		}
+		if(self->opticalFlowEnabled) {
+			//Bad landmarks must not be propagated. The next prediction for that face goes back to the shape predictor.
+			for(FaceTrackerOutput output : frameOutput.faces) {
+				if(output.faceId >= 0 && !self->faceDetector->getTrackingHealthIsGood(output.health)) {
+					self->flowReferences.erase(output.faceId);
+				}
+			}
+			for(auto iterator = self->flowReferences.begin(); iterator != self->flowReferences.end();) {
+				if(frameStartTimestamp - iterator->second.timestamps.startTimestamp > self->opticalFlowMaxGapSeconds) {
+					iterator = self->flowReferences.erase(iterator);
+				} else {
+					++iterator;
+				}
+			}
+		}
+		self->outputFrames[myFrameNumber] = frameOutput;
 		YerFace_MutexUnlock(self->myMutex);
 
 		self->frameServer->setWorkingFrameStatusCheckpoint(myFrameNumber, FRAME_STATUS_TRACKING, "faceTracker.ran");
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Logger.hpp"
 #include "Status.hpp"
 #include "SDLDriver.hpp"
 #include "FaceDetector.hpp"
+#include "FaceLandmarks.hpp"
 #include "MarkerType.hpp"
 #include "FrameServer.hpp"
 #include "Metrics.hpp"
@@ -16,76 +18,13 @@ using namespace std;
 
 namespace YerFace {
 
-class DlibPointPointer;
-
-enum DlibFeatureIndexes {
-	IDX_JAWLINE_0 = 0, //Uppermost right side.
-	IDX_JAWLINE_1 = 1,
-	IDX_JAWLINE_2 = 2,
-	IDX_JAWLINE_3 = 3,
-	IDX_JAWLINE_4 = 4,
-	IDX_JAWLINE_5 = 5,
-	IDX_JAWLINE_6 = 6,
-	IDX_JAWLINE_7 = 7,
-	IDX_JAWLINE_8 = 8, //Chin
-	IDX_JAWLINE_9 = 9,
-	IDX_JAWLINE_10 = 10,
-	IDX_JAWLINE_11 = 11,
-	IDX_JAWLINE_12 = 12,
-	IDX_JAWLINE_13 = 13,
-	IDX_JAWLINE_14 = 14,
-	IDX_JAWLINE_15 = 15,
-	IDX_JAWLINE_16 = 16, //Uppermost left side.
-	IDX_LEFTEYEBROW_FAROUTER = 17,
-	IDX_LEFTEYEBROW_NEAROUTER = 18,
-	IDX_LEFTEYEBROW_MIDDLE = 19,
-	IDX_LEFTEYEBROW_NEARINNER = 20,
-	IDX_LEFTEYEBROW_FARINNER = 21,
-	IDX_RIGHTEYEBROW_FARINNER = 22,
-	IDX_RIGHTEYEBROW_NEARINNER = 23,
-	IDX_RIGHTEYEBROW_MIDDLE = 24,
-	IDX_RIGHTEYEBROW_NEAROUTER = 25,
-	IDX_RIGHTEYEBROW_FAROUTER = 26,
-	IDX_NOSE_SELLION = 27, //Bridge of the nose
-	IDX_NOSE_TIP = 30,
-	IDX_RIGHTEYE_OUTER_CORNER = 36,
-	IDX_RIGHTEYE_UPPERLID_RIGHT = 37,
-	IDX_RIGHTEYE_UPPERLID_LEFT = 38,
-	IDX_RIGHTEYE_INNER_CORNER = 39,
-	IDX_RIGHTEYE_LOWERLID_LEFT = 40,
-	IDX_RIGHTEYE_LOWERLID_RIGHT = 41,
-	IDX_LEFTEYE_INNER_CORNER = 42,
-	IDX_LEFTEYE_UPPERLID_RIGHT = 43,
-	IDX_LEFTEYE_UPPERLID_LEFT = 44,
-	IDX_LEFTEYE_OUTER_CORNER = 45,
-	IDX_LEFTEYE_LOWERLID_LEFT = 46,
-	IDX_LEFTEYE_LOWERLID_RIGHT = 47,
-	IDX_MOUTHOUT_RIGHT_CORNER = 48,
-	IDX_MOUTHOUT_RIGHT_FAROUTER_TOP = 49,
-	IDX_MOUTHOUT_RIGHT_NEAROUTER_TOP = 50,
-	IDX_MOUTHOUT_CENTER_TOP = 51,
-	IDX_MOUTHOUT_LEFT_NEAROUTER_TOP = 52,
-	IDX_MOUTHOUT_LEFT_FAROUTER_TOP = 53,
-	IDX_MOUTHOUT_LEFT_CORNER = 54,
-	IDX_MOUTHOUT_LEFT_FAROUTER_BOTTOM = 55,
-	IDX_MOUTHOUT_LEFT_NEAROUTER_BOTTOM = 56,
-	IDX_MOUTHOUT_CENTER_BOTTOM = 57,
-	IDX_MOUTHOUT_RIGHT_NEAROUTER_BOTTOM = 58,
-	IDX_MOUTHOUT_RIGHT_FAROUTER_BOTTOM = 59,
-	IDX_MOUTHIN_RIGHT_CORNER = 60,
-	IDX_MOUTHIN_RIGHT_TOP = 61,
-	IDX_MOUTHIN_CENTER_TOP = 62,
-	IDX_MOUTHIN_LEFT_TOP = 63,
-	IDX_MOUTHIN_LEFT_CORNER = 64,
-	IDX_MOUTHIN_LEFT_BOTTOM = 65,
-	IDX_MOUTHIN_CENTER_BOTTOM = 66,
-	IDX_MOUTHIN_RIGHT_BOTTOM = 67
-};
-
 class FacialPose {
 public:
-	cv::Mat translationVector, rotationMatrix;
-	cv::Mat translationVectorInternal, rotationMatrixInternal;
+	cv::Vec3d translationVector;
+	cv::Matx33d rotationMatrix;
+	cv::Vec3d translationVectorInternal;
+	cv::Matx33d rotationMatrixInternal;
+	cv::Vec4d rotationQuaternion, rotationQuaternionInternal; //The same rotations as the matrices above. Smoothing and rejection work on these.
 	cv::Vec3d facialPlaneNormal;
 	double timestamp;
 	bool set;
@@ -113,7 +52,26 @@ public:
 
 class FacialCameraModel {
 public:
-	cv::Mat cameraMatrix, distortionCoefficients;
+	cv::Matx33d cameraMatrix;
+	cv::Vec4d distortionCoefficients;
+	bool set;
+};
+
+class FacialTrackingBox {
+public:
+	cv::Rect2d boxNormalSize; //Derived from the landmarks of a previous frame, in the coordinates of the full sized frame.
+	FrameTimestamps timestamps; //The frame from which the landmarks came.
+	bool set;
+};
+
+class FaceTrackerFlowReference {
+public:
+	cv::Mat grayROI; //Grayscale crop of the search frame around the landmarks.
+	cv::Rect roi; //Where grayROI came from, in search frame coordinates.
+	double searchFrameScaleFactor;
+	std::vector<cv::Point2f> landmarks; //Only the predicted landmarks, in landmarkIndexes order. In search frame coordinates.
+	FrameTimestamps timestamps; //The frame from which the landmarks came.
+	double lastPredictionTimestamp; //When the shape predictor last ran for this face.
 	bool set;
 };
 
@@ -123,10 +81,61 @@ class FaceTrackerOutput {
 public:
 	bool set;
 	FrameNumber frameNumber;
+	int faceId; //Matches FacialDetectionFace::faceId, or -1 if there is no face.
 	FacialFeaturesInternal facialFeatures;
 	FacialPose facialPose;
+	FacialPose solvedPose; //Unsmoothed pose, solved on a predictor worker. Rejection and smoothing happen later, in frame order.
+	cv::Vec3d solvedRotationVector; //Raw solvePnP output, kept so an accepted pose can seed later solutions.
+	bool solvedPoseInBounds;
+	FaceTrackingHealth health;
 };
 
+class FaceTrackerFrameOutput {
+public:
+	std::vector<FaceTrackerOutput> faces; //Never empty. The first face is the primary face.
+	size_t predictionsPending;
+};
+
+class FaceTrackerPredictionTask {
+public:
+	FrameNumber frameNumber;
+	size_t faceIndex;
+};
+
+class FaceTrackerFaceState {
+public:
+	list<FacialPose> facialPoseSmoothingBuffer; //Only used by windowed smoothing.
+	FacialPose recursiveSmoothedPose; //Only used by recursive smoothing.
+	FacialPose previouslyReportedFacialPose;
+	cv::Vec3d poseSolverSeedRotationVector, poseSolverSeedTranslationVector; //Raw solvePnP output from the last accepted pose.
+	bool poseSolverSeedSet;
+	std::vector<cv::Point2d> landmarkFilterValues, landmarkFilterVelocities; //One-Euro filter state, one entry per landmark.
+	double landmarkFilterTimestamp;
+	bool landmarkFilterSet;
+	double lastSeenTimestamp;
+	void resetPoseHistory(void) {
+		previouslyReportedFacialPose.set = false;
+		poseSolverSeedSet = false;
+		landmarkFilterSet = false;
+	}
+};
+
+//A face missing from a frame loses its pose history, just like a face whose landmarks went missing. Otherwise, when it comes back, it would be held to the one-frame rejection thresholds against a stale pose.
+static inline void resetAbsentFaceStates(unordered_map<int, FaceTrackerFaceState> *faceStates, const std::vector<FaceTrackerOutput> &faces) {
+	for(auto &statePair : *faceStates) {
+		bool present = false;
+		for(const FaceTrackerOutput &output : faces) {
+			if(output.faceId == statePair.first) {
+				present = true;
+				break;
+			}
+		}
+		if(!present) {
+			statePair.second.resetPoseHistory();
+		}
+	}
+}
+
 class FaceTrackerAssignmentTask {
 public:
 	FrameNumber frameNumber;
@@ -135,32 +144,64 @@ public:
 
 class FaceTracker {
 public:
-	FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver, FrameServer *myFrameServer, FaceDetector *myFaceDetector);
+	FaceTracker(json config, Status *myStatus, SDLDriver *mySDLDriver, FrameServer *myFrameServer, FaceDetector *myFaceDetector, bool myLowLatency);
 	~FaceTracker() noexcept(false);
 	void renderPreviewHUD(cv::Mat frame, FrameNumber frameNumber, int density, bool mirrorMode);
-	FacialFeatures getFacialFeatures(FrameNumber frameNumber);
+	size_t getNumFaces(FrameNumber frameNumber);
+	int getFaceId(FrameNumber frameNumber, size_t faceIndex);
+	FacialFeatures getFacialFeatures(FrameNumber frameNumber, size_t faceIndex = 0);
 	FacialCameraModel getFacialCameraModel(void);
-	FacialPose getFacialPose(FrameNumber frameNumber);
-	FacialPlane getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType);
+	FacialPose getFacialPose(FrameNumber frameNumber, size_t faceIndex = 0);
+	FacialPlane getCalculatedFacialPlaneForWorkingFacialPose(FrameNumber frameNumber, MarkerType markerType, size_t faceIndex = 0);
 private:
+	FaceTrackerOutput getFaceTrackerOutput(FrameNumber frameNumber, size_t faceIndex, const char *caller);
 	void doIdentifyFeatures(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	void doInitializeCameraModel(WorkingFrame *workingFrame);
+	void doSolveFacialPose(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
+	void doFilterLandmarks(WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	void doCalculateFacialTransformation(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
 	void doPrecalculateFacialPlaneNormal(WorkerPoolWorker *worker, WorkingFrame *workingFrame, FaceTrackerOutput *output);
-	bool doConvertLandmarkPointToImagePoint(DlibPointPointer pointPointer, cv::Point2d *dst, double detectionScaleFactor);
+	void doInitializeOutput(FaceTrackerOutput *output, FrameTimestamps frameTimestamps, int faceId);
+	bool doPrepareAdaptiveLandmarkCrop(WorkingFrame *workingFrame, cv::Rect2d searchRectNormalSize, cv::Mat *crop, double *cropScaleFactor, cv::Point2d *cropOffset);
+	bool getLandmarkBoxIsUsable(FacialTrackingBox box, FrameTimestamps frameTimestamps);
+	cv::Rect2d getFlowReferenceBox(FaceTrackerFlowReference reference);
+	bool getBoxIsDetectedFace(cv::Rect2d boxNormalSize, FacialDetectionBox facialDetection);
+	bool getFlowReferenceIsUsable(FaceTrackerFlowReference reference, FrameTimestamps frameTimestamps);
+	bool doPropagateLandmarks(cv::Mat searchFrame, double searchFrameScaleFactor, FaceTrackerOutput *output, FaceTrackerFlowReference reference, std::vector<cv::Point2d> *landmarks);
+	void doStoreFlowReference(cv::Mat searchFrame, double searchFrameScaleFactor, FaceTrackerOutput *output, std::vector<cv::Point2d> landmarks, double lastPredictionTimestamp);
+	void doParkUnpredictedLandmarks(std::vector<cv::Point2d> *landmarks);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static void predictorWorkerInitializer(WorkerPoolWorker *worker, void *ptr);
 	static bool predictorWorkerHandler(WorkerPoolWorker *worker);
 	static bool assignmentWorkerHandler(WorkerPoolWorker *worker);
 
 	string featureDetectionModelFileName, faceDetectionModelFileName;
+	std::vector<int> landmarkIndexes; //Which iBUG landmark each of the shape predictor's parts is.
+	std::vector<int> unpredictedLandmarkIndexes; //iBUG landmarks the shape predictor doesn't know about.
+	std::vector<bool> landmarkPredicted; //For each iBUG landmark, whether the shape predictor actually predicts it.
 	bool useFullSizedFrameForLandmarkDetection;
+	bool adaptiveLandmarkCropEnabled; //Predict landmarks on a crop of the full sized frame, resampled so the eyes are about adaptiveLandmarkCropInterOcularPixels apart.
+	double adaptiveLandmarkCropInterOcularPixels;
+	bool lowLatency;
+	bool landmarkBoxEnabled; //Search for landmarks within a box derived from the previous landmarks, using the detector only to initialize and recover.
+	double landmarkBoxGoodForSeconds;
+	bool opticalFlowEnabled; //Propagate the previous landmarks with optical flow, running the shape predictor only on a cadence or when the flow goes bad.
+	double opticalFlowFullPredictionIntervalSeconds, opticalFlowMaxGapSeconds, opticalFlowMaxForwardBackwardError;
+	int opticalFlowWindowSize, opticalFlowPyramidLevels;
+	bool landmarkFilterEnabled; //Run each landmark through a One-Euro filter, in frame order, before anything downstream sees it.
+	double landmarkFilterMinCutoff, landmarkFilterBeta, landmarkFilterDerivativeCutoff;
 	Status *status;
 	SDLDriver *sdlDriver;
 	FrameServer *frameServer;
 	FaceDetector *faceDetector;
+	int poseSolverMethod; //One of OpenCV's SOLVEPNP_* flags.
+	bool poseSolverWarmStart; //Seed the iterative solver with the last accepted pose.
+	bool poseSolverRefine; //Polish each solution with a Levenberg-Marquardt refinement.
+	bool poseSmoothingRecursive; //Constant cost exponential filter instead of re-weighting a window of recent poses.
 	double poseSmoothingOverSeconds;
 	double poseSmoothingExponent;
+	double poseSmoothingTimeConstant;
 	double poseRotationLowRejectionThreshold;
 	double poseTranslationLowRejectionThreshold;
 	double poseRotationLowRejectionThresholdInternal;
@@ -186,19 +227,23 @@ private:
 	cv::Point3d vertexMenton;
 	cv::Point3d vertexStommion;
 	double depthSliceA, depthSliceB, depthSliceC, depthSliceD, depthSliceE, depthSliceF, depthSliceG, depthSliceH;
+	double markerTypeDepths[NoMarkerAssigned]; //Which depth slice each marker type lies on.
+	std::vector<int> correlationLandmarkIndexes; //Landmarks which feed solvePnP, in the same order as correlationVertices.
+	std::vector<cv::Point3d> correlationVertices; //The rigid head model. The final vertex (stommion) is derived from two landmarks.
 
 	Logger *logger;
-	Metrics *metricsPredictor, *metricsAssignment;
+	Metrics *metricsPredictor, *metricsAssignment, *metricsTransformation;
 
-	list<FacialPose> facialPoseSmoothingBuffer;
-	FacialPose previouslyReportedFacialPose;
+	unordered_map<int, FaceTrackerFaceState> faceStates; //Keyed by face ID.
 	FacialCameraModel facialCameraModel;
+	unordered_map<int, FacialTrackingBox> landmarkBoxes; //Keyed by face ID.
+	unordered_map<int, FaceTrackerFlowReference> flowReferences; //Keyed by face ID.
 
 	SDL_mutex *myMutex, *myAssignmentMutex;
 
-	std::list<FrameNumber> pendingPredictionFrameNumbers;
+	std::list<FaceTrackerPredictionTask> pendingPredictions;
 	unordered_map<FrameNumber, FaceTrackerAssignmentTask> pendingAssignmentFrameNumbers;
-	unordered_map<FrameNumber, FaceTrackerOutput> outputFrames;
+	unordered_map<FrameNumber, FaceTrackerFrameOutput> outputFrames;
 
 	WorkerPool *predictorWorkerPool, *assignmentWorkerPool;
 };
@@ -28,6 +28,12 @@ FrameServer::FrameServer(json config, Status *myStatus, bool myLowLatency) {
 	if(detectionScaleFactor < 0.0 || detectionScaleFactor > 1.0) {
 		throw invalid_argument("Detection Scale Factor is invalid.");
 	}
+	stallThresholdSeconds = config["YerFace"]["FrameServer"]["stallThresholdSeconds"];
+	if(stallThresholdSeconds < 0.0) {
+		throw invalid_argument("Stall Threshold Seconds cannot be negative.");
+	}
+	lastStallReport = 0.0;
+	lastHerderRun = 0.0;
 
 	for(unsigned int i = 0; i <= FRAME_STATUS_MAX; i++) {
 		onFrameStatusChangeCallbacks[i].clear();
@@ -36,11 +42,17 @@ FrameServer::FrameServer(json config, Status *myStatus, bool myLowLatency) {
 	if((myMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
+	if((stallCallbacksMutex = SDL_CreateMutex()) == NULL) {
+		throw runtime_error("Failed creating mutex!");
+	}
 
 	metrics = new Metrics(config, "FrameServer");
+	frameStoreGauge = new MemoryGauge("FrameServer.FrameStore");
 
 	draining = false;
 	mirrorMode = false;
+	detectionMinimumObjectFraction = 0.0;
+	detectorMinimumObjectPixels = 0;
 	workerPool = NULL;
 
 	WorkerPoolParameters workerPoolParameters;
@@ -74,7 +86,9 @@ FrameServer::~FrameServer() noexcept(false) {
 	}
 	YerFace_MutexUnlock(myMutex);
 
+	SDL_DestroyMutex(stallCallbacksMutex);
 	SDL_DestroyMutex(myMutex);
+	delete frameStoreGauge;
 	delete metrics;
 	delete logger;
 }
@@ -85,6 +99,40 @@ void FrameServer::onFrameServerDrainedEvent(FrameServerDrainedEventCallback call
 	YerFace_MutexUnlock(myMutex);
 }
 
+void FrameServer::onFrameServerStallEvent(FrameServerStallEventCallback callback) {
+	YerFace_MutexLock(myMutex);
+	onFrameServerStallCallbacks.push_back(callback);
+	YerFace_MutexUnlock(myMutex);
+}
+
+void FrameServer::removeFrameServerDrainedEvent(void *userdata) {
+	//Drained callbacks fire with our mutex held, so once we have it none can be in flight.
+	YerFace_MutexLock(myMutex);
+	for(auto iterator = onFrameServerDrainedCallbacks.begin(); iterator != onFrameServerDrainedCallbacks.end();) {
+		if(iterator->userdata == userdata) {
+			iterator = onFrameServerDrainedCallbacks.erase(iterator);
+		} else {
+			++iterator;
+		}
+	}
+	YerFace_MutexUnlock(myMutex);
+}
+
+void FrameServer::removeFrameServerStallEvent(void *userdata) {
+	//Waits out any stall report in progress, so the caller is safe to destruct as soon as we return.
+	YerFace_MutexLock(stallCallbacksMutex);
+	YerFace_MutexLock(myMutex);
+	for(auto iterator = onFrameServerStallCallbacks.begin(); iterator != onFrameServerStallCallbacks.end();) {
+		if(iterator->userdata == userdata) {
+			iterator = onFrameServerStallCallbacks.erase(iterator);
+		} else {
+			++iterator;
+		}
+	}
+	YerFace_MutexUnlock(myMutex);
+	YerFace_MutexUnlock(stallCallbacksMutex);
+}
+
 void FrameServer::onFrameStatusChangeEvent(FrameStatusChangeEventCallback callback) {
 	checkStatusValue(callback.newStatus);
 	YerFace_MutexLock(myMutex);
@@ -146,10 +194,23 @@ void FrameServer::insertNewFrame(VideoFrame *videoFrame) {
 			detectionScaleFactor = (double)detectionBoundingBox / (double)frameSize.height;
 		}
 	}
+	if(detectionMinimumObjectFraction > 0.0) {
+		//There is no point handing the detector more pixels than it takes to make the smallest object we care about
+		//as small as the smallest object the detector can find. Scaling down further skips useless pyramid levels.
+		double usefulScaleFactor = (double)detectorMinimumObjectPixels / (detectionMinimumObjectFraction * (double)std::min(frameSize.width, frameSize.height));
+		if(detectionScaleFactor > usefulScaleFactor) {
+			detectionScaleFactor = usefulScaleFactor;
+		}
+	}
 	workingFrame->detectionScaleFactor = detectionScaleFactor;
 
 	resize(workingFrame->frame, workingFrame->detectionFrame, Size(), detectionScaleFactor, detectionScaleFactor);
 
+	workingFrame->bitmapBytes = (int64_t)(workingFrame->frame.total() * workingFrame->frame.elemSize());
+	workingFrame->bitmapBytes += (int64_t)(workingFrame->detectionFrame.total() * workingFrame->detectionFrame.elemSize());
+	workingFrame->bitmapBytes += (int64_t)(workingFrame->previewFrame.total() * workingFrame->previewFrame.elemSize());
+	frameStoreGauge->allocated(workingFrame->bitmapBytes);
+
 	static bool reportedScale = false;
 	if(!reportedScale) {
 		logger->debug1("Scaled current frame <%dx%d> down to <%dx%d> for detection", frameSize.width, frameSize.height, workingFrame->detectionFrame.size().width, workingFrame->detectionFrame.size().height);
@@ -164,7 +225,7 @@ void FrameServer::insertNewFrame(VideoFrame *videoFrame) {
 	}
 
 	frameStore[workingFrame->frameTimestamps.frameNumber] = workingFrame;
-	logger->debug4("Inserted new working frame " YERFACE_FRAMENUMBER_FORMAT " into frame store. Frame store size is now %lu", workingFrame->frameTimestamps.frameNumber, frameStore.size());
+	YerFace_LogDebug4(logger, "Inserted new working frame " YERFACE_FRAMENUMBER_FORMAT " into frame store. Frame store size is now %lu", workingFrame->frameTimestamps.frameNumber, frameStore.size());
 
 	setFrameStatus(workingFrame->frameTimestamps, FRAME_STATUS_NEW);
 
@@ -200,6 +261,19 @@ void FrameServer::setMirrorMode(bool myMirrorMode) {
 	YerFace_MutexUnlock(myMutex);
 }
 
+void FrameServer::setDetectionMinimumObjectSize(double minimumObjectFraction, int myDetectorMinimumObjectPixels) {
+	if(minimumObjectFraction < 0.0 || minimumObjectFraction > 1.0) {
+		throw invalid_argument("minimumObjectFraction must be between 0.0 and 1.0 inclusive.");
+	}
+	if(myDetectorMinimumObjectPixels < 1) {
+		throw invalid_argument("detectorMinimumObjectPixels must be at least one.");
+	}
+	YerFace_MutexLock(myMutex);
+	detectionMinimumObjectFraction = minimumObjectFraction;
+	detectorMinimumObjectPixels = myDetectorMinimumObjectPixels;
+	YerFace_MutexUnlock(myMutex);
+}
+
 WorkingFrame *FrameServer::getWorkingFrame(FrameNumber frameNumber) {
 	YerFace_MutexLock(myMutex);
 	auto frameIter = frameStore.find(frameNumber);
@@ -242,6 +316,13 @@ void FrameServer::setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, Worki
 	YerFace_MutexUnlock(myMutex);
 }
 
+bool FrameServer::getIsDraining(void) {
+	YerFace_MutexLock(myMutex);
+	bool status = draining;
+	YerFace_MutexUnlock(myMutex);
+	return status;
+}
+
 bool FrameServer::isDrained(void) {
 	bool drained;
 	YerFace_MutexLock(myMutex);
@@ -252,8 +333,9 @@ bool FrameServer::isDrained(void) {
 }
 
 void FrameServer::destroyFrame(FrameNumber frameNumber) {
-	logger->debug4("Cleaning up GONE Frame #" YERFACE_FRAMENUMBER_FORMAT " ...", frameNumber);
+	YerFace_LogDebug4(logger, "Cleaning up GONE Frame #" YERFACE_FRAMENUMBER_FORMAT " ...", frameNumber);
 	SDL_DestroyMutex(frameStore[frameNumber]->previewFrameMutex);
+	frameStoreGauge->released(frameStore[frameNumber]->bitmapBytes);
 	delete frameStore[frameNumber];
 	frameStore.erase(frameNumber);
 
@@ -268,7 +350,8 @@ void FrameServer::setFrameStatus(FrameTimestamps frameTimestamps, WorkingFrameSt
 	checkStatusValue(newStatus);
 	YerFace_MutexLock(myMutex);
 	frameStore[frameTimestamps.frameNumber]->status = newStatus;
-	logger->debug4("Setting Frame #" YERFACE_FRAMENUMBER_FORMAT " Status to %d ...", frameTimestamps.frameNumber, newStatus);
+	frameStore[frameTimestamps.frameNumber]->statusChangedTime = (double)getTickCount() / (double)getTickFrequency();
+	YerFace_LogDebug4(logger, "Setting Frame #" YERFACE_FRAMENUMBER_FORMAT " Status to %d ...", frameTimestamps.frameNumber, newStatus);
 	for(auto callback : onFrameStatusChangeCallbacks[newStatus]) {
 		callback.callback(callback.userdata, newStatus, frameTimestamps);
 	}
@@ -281,14 +364,72 @@ void FrameServer::checkStatusValue(WorkingFrameStatus status) {
 	}
 }
 
+string FrameServer::getWorkingFrameStatusString(WorkingFrameStatus status) {
+	switch(status) {
+		case FRAME_STATUS_NEW:
+			return "NEW";
+		case FRAME_STATUS_PREPROCESS:
+			return "PREPROCESS";
+		case FRAME_STATUS_DETECTION:
+			return "DETECTION";
+		case FRAME_STATUS_TRACKING:
+			return "TRACKING";
+		case FRAME_STATUS_MAPPING:
+			return "MAPPING";
+		case FRAME_STATUS_PREVIEW_DISPLAY:
+			return "PREVIEW_DISPLAY";
+		case FRAME_STATUS_LATE_PROCESSING:
+			return "LATE_PROCESSING";
+		case FRAME_STATUS_DRAINING:
+			return "DRAINING";
+		case FRAME_STATUS_GONE:
+			return "GONE";
+	}
+	return "?????";
+}
+
+void FrameServer::logStalledFrame(WorkingFrame *workingFrame, double stalledSeconds, size_t numStalledFrames) {
+	YerFace_MutexLock(myMutex);
+	logger->warning("STALL DETECTED! Frame #" YERFACE_FRAMENUMBER_FORMAT " has been stuck in status %s for %.02lf seconds. (%lu frame(s) are past the stall threshold of %.02lf seconds.)", workingFrame->frameTimestamps.frameNumber, getWorkingFrameStatusString(workingFrame->status).c_str(), stalledSeconds, numStalledFrames, stallThresholdSeconds);
+
+	string pendingCheckpoints = "";
+	for(auto checkpointPair : workingFrame->checkpoints[workingFrame->status]) {
+		if(!checkpointPair.second) {
+			pendingCheckpoints += (pendingCheckpoints.length() > 0 ? ", " : "") + checkpointPair.first;
+		}
+	}
+	logger->warning("... Frame #" YERFACE_FRAMENUMBER_FORMAT " is still waiting on checkpoints: [%s]", workingFrame->frameTimestamps.frameNumber, pendingCheckpoints.c_str());
+
+	size_t statusCounts[FRAME_STATUS_MAX + 1] = {};
+	for(auto framePair : frameStore) {
+		statusCounts[framePair.second->status]++;
+	}
+	string statusSummary = "";
+	for(unsigned int i = 0; i <= FRAME_STATUS_MAX; i++) {
+		if(statusCounts[i] > 0) {
+			statusSummary += (statusSummary.length() > 0 ? ", " : "") + getWorkingFrameStatusString((WorkingFrameStatus)i) + ": " + to_string(statusCounts[i]);
+		}
+	}
+	logger->warning("... Frame store depth is %lu. Frames by status: [%s]", frameStore.size(), statusSummary.c_str());
+	MemoryGauge::logAllReadings(logger, LOG_SEVERITY_WARNING);
+	YerFace_MutexUnlock(myMutex);
+}
+
 bool FrameServer::workerHandler(WorkerPoolWorker *worker) {
 	FrameServer *self = (FrameServer *)worker->ptr;
 
 	bool didWork = false;
 	std::list<FrameNumber> garbageFrames;
+	double now = (double)getTickCount() / (double)getTickFrequency();
+	WorkingFrame *stalledFrame = NULL;
+	size_t numStalledFrames = 0;
 
 	YerFace_MutexLock(self->myMutex);
 
+	//If the herder hasn't run for a while (for example, because we were paused) then the stall timers are meaningless. Restart them.
+	bool restartStallTimers = self->stallThresholdSeconds > 0.0 && self->lastHerderRun > 0.0 && now - self->lastHerderRun >= self->stallThresholdSeconds;
+	self->lastHerderRun = now;
+
 	// self->logger->verbose("Frame Herder Top-of-loop. FrameStore size: %lu", self->frameStore.size());
 	for(auto framePair : self->frameStore) {
 		FrameNumber frameNumber = framePair.first;
@@ -302,6 +443,10 @@ bool FrameServer::workerHandler(WorkerPoolWorker *worker) {
 			continue;
 		}
 
+		if(restartStallTimers) {
+			workingFrame->statusChangedTime = now;
+		}
+
 		//Is this frame eligible for a new status?
 		bool checkpointsPassed = true;
 		for(auto checkpointPair : workingFrame->checkpoints[status]) {
@@ -318,13 +463,29 @@ bool FrameServer::workerHandler(WorkerPoolWorker *worker) {
 				workingFrame->frame.release();
 				workingFrame->detectionFrame.release();
 				workingFrame->previewFrame.release();
+				self->frameStoreGauge->released(workingFrame->bitmapBytes, 0);
+				workingFrame->bitmapBytes = 0;
 			}
 
 			didWork = true;
 			self->setFrameStatus(workingFrame->frameTimestamps, (WorkingFrameStatus)(status + 1));
+		} else if(self->stallThresholdSeconds > 0.0 && now - workingFrame->statusChangedTime >= self->stallThresholdSeconds) {
+			//This frame has been sitting in one status for too long. Keep track of the oldest offender.
+			numStalledFrames++;
+			if(stalledFrame == NULL || workingFrame->frameTimestamps.frameNumber < stalledFrame->frameTimestamps.frameNumber) {
+				stalledFrame = workingFrame;
+			}
 		}
 	}
 
+	//Report stalls at most once per stall threshold interval, so a stuck pipeline doesn't flood the log.
+	bool stallReported = false;
+	if(stalledFrame != NULL && now - self->lastStallReport >= self->stallThresholdSeconds) {
+		self->lastStallReport = now;
+		self->logStalledFrame(stalledFrame, now - stalledFrame->statusChangedTime, numStalledFrames);
+		stallReported = true;
+	}
+
 	//Destroy GONE frames.
 	while(garbageFrames.size() > 0) {
 		self->destroyFrame(garbageFrames.front());
@@ -333,6 +494,18 @@ bool FrameServer::workerHandler(WorkerPoolWorker *worker) {
 
 	YerFace_MutexUnlock(self->myMutex);
 
+	//Stall callbacks are fired without holding our mutex, so that modules can lock their own state to report on it.
+	if(stallReported) {
+		YerFace_MutexLock(self->stallCallbacksMutex);
+		YerFace_MutexLock(self->myMutex);
+		std::vector<FrameServerStallEventCallback> stallCallbacks = self->onFrameServerStallCallbacks;
+		YerFace_MutexUnlock(self->myMutex);
+		for(auto callback : stallCallbacks) {
+			callback.callback(callback.userdata);
+		}
+		YerFace_MutexUnlock(self->stallCallbacksMutex);
+	}
+
 	return didWork;
 }
 
@@ -6,6 +6,7 @@
 #include "Utilities.hpp"
 #include "FFmpegDriver.hpp"
 #include "WorkerPool.hpp"
+#include "MemoryGauge.hpp"
 
 #include <list>
 
@@ -44,8 +45,10 @@ public:
 	cv::Mat previewFrame; //BGR, same as the input frame, but possibly with some HUD stuff scribbled onto it.
 	SDL_mutex *previewFrameMutex; //IMPORTANT - make sure you lock previewFrameMutex before WRITING TO or READING FROM previewFrame.
 	FrameTimestamps frameTimestamps;
+	int64_t bitmapBytes; //Total size of the bitmaps held by this frame, for memory accounting.
 
 	WorkingFrameStatus status;
+	double statusChangedTime; //Monotonic clock time at which this frame entered its current status. (Used for stall detection.)
 	unordered_map<string, bool> checkpoints[FRAME_STATUS_MAX + 1];
 };
 
@@ -62,23 +65,36 @@ public:
 	function<void(void *userdata)> callback;
 };
 
+class FrameServerStallEventCallback {
+public:
+	void *userdata;
+	function<void(void *userdata)> callback;
+};
+
 class FrameServer {
 public:
 	FrameServer(json config, Status *myStatus, bool myLowLatency);
 	~FrameServer() noexcept(false);
 	void setDraining(void);
+	bool getIsDraining(void);
 	void setMirrorMode(bool myMirrorMode);
+	void setDetectionMinimumObjectSize(double minimumObjectFraction, int detectorMinimumObjectPixels);
 	void onFrameServerDrainedEvent(FrameServerDrainedEventCallback callback);
+	void onFrameServerStallEvent(FrameServerStallEventCallback callback);
+	void removeFrameServerDrainedEvent(void *userdata);
+	void removeFrameServerStallEvent(void *userdata);
 	void onFrameStatusChangeEvent(FrameStatusChangeEventCallback callback);
 	void registerFrameStatusCheckpoint(WorkingFrameStatus status, string checkpointKey);
 	void insertNewFrame(VideoFrame *videoFrame);
 	WorkingFrame *getWorkingFrame(FrameNumber frameNumber);
 	void setWorkingFrameStatusCheckpoint(FrameNumber frameNumber, WorkingFrameStatus status, string checkpointKey);
+	static string getWorkingFrameStatusString(WorkingFrameStatus status);
 private:
 	bool isDrained(void);
 	void destroyFrame(FrameNumber frameNumber);
 	void setFrameStatus(FrameTimestamps frameTimestamps, WorkingFrameStatus newStatus);
 	void checkStatusValue(WorkingFrameStatus status);
+	void logStalledFrame(WorkingFrame *workingFrame, double stalledSeconds, size_t numStalledFrames);
 	static bool workerHandler(WorkerPoolWorker *worker);
 	static void workerDeinitializer(WorkerPoolWorker *worker, void *usrPtr);
 
@@ -88,9 +104,15 @@ private:
 	bool mirrorMode;
 	int detectionBoundingBox;
 	double detectionScaleFactor;
+	double detectionMinimumObjectFraction;
+	int detectorMinimumObjectPixels;
+	double stallThresholdSeconds;
+	double lastStallReport, lastHerderRun;
 	Logger *logger;
 	SDL_mutex *myMutex;
+	SDL_mutex *stallCallbacksMutex; //Held while stall callbacks are firing, so they can be removed safely.
 	Metrics *metrics;
+	MemoryGauge *frameStoreGauge;
 	cv::Size frameSize;
 	bool frameSizeSet;
 
@@ -100,6 +122,7 @@ private:
 	std::vector<string> statusCheckpoints[FRAME_STATUS_MAX + 1];
 
 	std::vector<FrameServerDrainedEventCallback> onFrameServerDrainedCallbacks;
+	std::vector<FrameServerStallEventCallback> onFrameServerStallCallbacks;
 
 	WorkerPool *workerPool;
 };
@@ -0,0 +1,139 @@
+
+#include "HardwareCounters.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace YerFace {
+
+#define HARDWARECOUNTERS_NUM_EVENTS 4
+
+static Logger *hardwareCountersLogger = new Logger("HardwareCounters");
+static std::atomic<bool> hardwareCountersWarned(false);
+
+class HardwareCountersThreadGroup {
+public:
+	HardwareCountersThreadGroup();
+	~HardwareCountersThreadGroup();
+	bool read(HardwareCounterSample *sample);
+private:
+	bool opened;
+	int fds[HARDWARECOUNTERS_NUM_EVENTS];
+};
+
+#ifdef __linux__
+
+HardwareCountersThreadGroup::HardwareCountersThreadGroup() {
+	opened = false;
+	for(int i = 0; i < HARDWARECOUNTERS_NUM_EVENTS; i++) {
+		fds[i] = -1;
+	}
+
+	//Order matters. This is the order in which values come back from read().
+	uint64_t configs[HARDWARECOUNTERS_NUM_EVENTS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	for(int i = 0; i < HARDWARECOUNTERS_NUM_EVENTS; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.disabled = (i == 0) ? 1 : 0; //The group leader starts disabled, and enables the whole group.
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+		fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, fds[0], 0);
+		if(fds[i] < 0) {
+			if(!hardwareCountersWarned.exchange(true)) {
+				hardwareCountersLogger->warning("Failed to open hardware performance counters (%s). Hardware counters will not be reported. (Check /proc/sys/kernel/perf_event_paranoid?)", strerror(errno));
+			}
+			return;
+		}
+	}
+	ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	opened = true;
+}
+
+HardwareCountersThreadGroup::~HardwareCountersThreadGroup() {
+	for(int i = HARDWARECOUNTERS_NUM_EVENTS - 1; i >= 0; i--) {
+		if(fds[i] >= 0) {
+			close(fds[i]);
+		}
+	}
+}
+
+bool HardwareCountersThreadGroup::read(HardwareCounterSample *sample) {
+	if(!opened) {
+		return false;
+	}
+	struct {
+		uint64_t nr;
+		uint64_t values[HARDWARECOUNTERS_NUM_EVENTS];
+	} groupRead;
+	if(::read(fds[0], &groupRead, sizeof(groupRead)) != (ssize_t)sizeof(groupRead) || groupRead.nr != HARDWARECOUNTERS_NUM_EVENTS) {
+		return false;
+	}
+	sample->cycles = groupRead.values[0];
+	sample->instructions = groupRead.values[1];
+	sample->cacheMisses = groupRead.values[2];
+	sample->branchMisses = groupRead.values[3];
+	return true;
+}
+
+#else
+
+HardwareCountersThreadGroup::HardwareCountersThreadGroup() {
+	opened = false;
+	if(!hardwareCountersWarned.exchange(true)) {
+		hardwareCountersLogger->warning("Hardware performance counters are only supported on Linux. Hardware counters will not be reported.");
+	}
+}
+
+HardwareCountersThreadGroup::~HardwareCountersThreadGroup() {
+}
+
+bool HardwareCountersThreadGroup::read(HardwareCounterSample *sample) {
+	return false;
+}
+
+#endif
+
+HardwareCounterSample HardwareCounters::sample(void) {
+	static thread_local HardwareCountersThreadGroup group;
+	HardwareCounterSample sample;
+	sample.group = &group;
+	sample.cycles = 0;
+	sample.instructions = 0;
+	sample.cacheMisses = 0;
+	sample.branchMisses = 0;
+	sample.valid = group.read(&sample);
+	return sample;
+}
+
+HardwareCounterSample HardwareCounters::difference(HardwareCounterSample end, HardwareCounterSample start) {
+	HardwareCounterSample delta;
+	delta.group = end.group;
+	delta.valid = end.valid && start.valid && end.group == start.group;
+	delta.cycles = delta.valid ? end.cycles - start.cycles : 0;
+	delta.instructions = delta.valid ? end.instructions - start.instructions : 0;
+	delta.cacheMisses = delta.valid ? end.cacheMisses - start.cacheMisses : 0;
+	delta.branchMisses = delta.valid ? end.branchMisses - start.branchMisses : 0;
+	return delta;
+}
+
+} //namespace YerFace
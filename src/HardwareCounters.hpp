@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Logger.hpp"
+
+#include <cstdint>
+
+using namespace std;
+
+namespace YerFace {
+
+class HardwareCountersThreadGroup;
+
+class HardwareCounterSample {
+public:
+	bool valid;
+	HardwareCountersThreadGroup *group; //Counters are per-thread, so samples may only be compared against samples from the same group.
+	uint64_t cycles, instructions, cacheMisses, branchMisses;
+};
+
+// HardwareCounters wraps the Linux perf_event_open() interface. Each thread
+// which takes a sample lazily opens its own counter group, which is counting
+// only that thread. On other platforms (or if the kernel refuses us) every
+// sample simply comes back invalid.
+class HardwareCounters {
+public:
+	static HardwareCounterSample sample(void);
+	static HardwareCounterSample difference(HardwareCounterSample end, HardwareCounterSample start);
+};
+
+}; //namespace YerFace
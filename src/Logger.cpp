@@ -70,7 +70,7 @@ namespace YerFace {
 #define CONSOLE_FONT_REVERSE_OFF			"\x1B[27m"
 #endif
 
-LogMessageSeverity Logger::severityFilter = LOG_SEVERITY_FILTERDEFAULT;
+std::atomic<LogMessageSeverity> Logger::severityFilter(LOG_SEVERITY_FILTERDEFAULT);
 bool Logger::outFileOpened = false;
 FILE *Logger::outFile = stderr;
 LogColorModes Logger::colorMode = LOG_COLORS_AUTO;
@@ -177,6 +177,11 @@ void Logger::slog(std::string moduleName, LogMessageSeverity severity, const cha
 }
 
 void Logger::svlog(std::string moduleName, LogMessageSeverity severity, const char *fmt, va_list args) {
+	//Drop messages according to the logging filter, before we do any other work.
+	if(!getSeverityIsEnabled(severity)) {
+		return;
+	}
+
 	if(moduleName.find('%') != string::npos) {
 		throw invalid_argument("Logger moduleName must not contain a percent sign.");
 	}
@@ -184,7 +189,6 @@ void Logger::svlog(std::string moduleName, LogMessageSeverity severity, const ch
 	HANDLE myWinConsole = NULL;
 	#endif
 	YerFace_MutexLock_Trivial(staticMutex);
-	LogMessageSeverity mySeverityFilter = severityFilter;
 	FILE *myOutFile = outFile;
 	LogColorModes myColorMode = colorMode;
 	if(myColorMode == LOG_COLORS_AUTO) {
@@ -213,11 +217,6 @@ void Logger::svlog(std::string moduleName, LogMessageSeverity severity, const ch
 	}
 	YerFace_MutexUnlock_Trivial(staticMutex);
 
-	//Drop messages according to the logging filter.
-	if(severity > mySeverityFilter) {
-		return;
-	}
-
 	//Trim any leading or trailing whitespace from fmt.
 	string originalFormat = Utilities::stringTrim((string)fmt);
 
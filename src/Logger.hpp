@@ -4,6 +4,7 @@
 
 #include "SDL.h"
 
+#include <atomic>
 #include <cstdarg>
 #include <string>
 
@@ -35,6 +36,13 @@ enum LogMessageSeverity: unsigned int {
 #define LOG_SEVERITY_MAX (LogMessageSeverity)10
 #define LOG_SEVERITY_FILTERDEFAULT LOG_SEVERITY_INFO
 
+// Messages more verbose than YERFACE_LOG_SEVERITY_COMPILED_MAX are compiled out of
+// the YerFace_Log* macros below. Normally this is set by the build system. (See
+// the YERFACE_STRIP_VERBOSE_LOGGING CMake option.)
+#ifndef YERFACE_LOG_SEVERITY_COMPILED_MAX
+#define YERFACE_LOG_SEVERITY_COMPILED_MAX LOG_SEVERITY_MAX
+#endif
+
 enum LogColorModes: unsigned int {
 	LOG_COLORS_OFF,
 	LOG_COLORS_ON,
@@ -85,11 +93,14 @@ public:
 	static void setLoggingColorMode(LogColorModes mode);
 	static void setLoggingFilter(LogMessageSeverity severity);
 	static std::string getSeverityString(LogMessageSeverity severity);
+	static bool getSeverityIsEnabled(LogMessageSeverity severity) {
+		return severity <= severityFilter.load(std::memory_order_relaxed);
+	}
 private:
 	static LogConsoleCode getSeverityStringConsoleCode(LogMessageSeverity severity);
 
 	std::string name;
-	static LogMessageSeverity severityFilter;
+	static std::atomic<LogMessageSeverity> severityFilter;
 	static bool outFileOpened;
 	static FILE *outFile;
 	static LogColorModes colorMode;
@@ -97,7 +108,23 @@ private:
 	static SDL_mutex *staticMutex;
 };
 
+// Evaluates to false (at compile time, when possible) if messages of the specified severity would be dropped.
+#define YerFace_LogSeverityEnabled(severity) \
+	((severity) <= YERFACE_LOG_SEVERITY_COMPILED_MAX && Logger::getSeverityIsEnabled(severity))
+
+// Unlike calling the Logger methods directly, these macros do not evaluate their arguments
+// (or make any function calls at all) if the message would be dropped by the logging filter.
+// Prefer these for anything which might be logged per-frame or per-packet.
+#define YerFace_Log(loggerPtr, severity, ...) \
+	do { if(YerFace_LogSeverityEnabled(severity)) { (loggerPtr)->log(severity, __VA_ARGS__); } } while(0)
+#define YerFace_LogDebug4(loggerPtr, ...) YerFace_Log(loggerPtr, LOG_SEVERITY_DEBUG4, __VA_ARGS__)
+#define YerFace_LogDebug3(loggerPtr, ...) YerFace_Log(loggerPtr, LOG_SEVERITY_DEBUG3, __VA_ARGS__)
+#define YerFace_LogDebug2(loggerPtr, ...) YerFace_Log(loggerPtr, LOG_SEVERITY_DEBUG2, __VA_ARGS__)
+#define YerFace_LogDebug1(loggerPtr, ...) YerFace_Log(loggerPtr, LOG_SEVERITY_DEBUG1, __VA_ARGS__)
+
 #define YerFace_SLog(moduleName, severity, fmt, ...) \
-	Logger::slog(moduleName, severity, "%s:%d: " fmt, YERFACE_FILE, __LINE__, __VA_ARGS__)
+	do { if(YerFace_LogSeverityEnabled(severity)) { \
+		Logger::slog(moduleName, severity, "%s:%d: " fmt, YERFACE_FILE, __LINE__, __VA_ARGS__); \
+	} } while(0)
 
 }; //namespace YerFace
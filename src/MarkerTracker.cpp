@@ -55,11 +55,6 @@ MarkerTracker::MarkerTracker(json config, MarkerType myMarkerType, FaceMapper *m
 	frameServer = faceMapper->getFrameServer();
 	faceTracker = faceMapper->getFaceTracker();
 
-	previouslyReportedMarkerPoint.set = false;
-	previouslyReportedMarkerPoint.timestamp.startTimestamp = -1.0;
-	previouslyReportedMarkerPoint.timestamp.estimatedEndTimestamp = -1.0;
-	previouslyReportedMarkerPoint.timestamp.frameNumber = -1;
-
 	if((myMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
@@ -88,24 +83,38 @@ MarkerType MarkerTracker::getMarkerType(void) {
 }
 
 void MarkerTracker::processFrame(FrameNumber frameNumber) {
-	MarkerPoint markerPoint;
-	markerPoint.set = false;
+	WorkingFrame *workingFrame = frameServer->getWorkingFrame(frameNumber);
+	size_t numFaces = faceTracker->getNumFaces(frameNumber);
+	std::vector<MarkerPoint> framePoints(numFaces);
 
-	assignMarkerPoint(frameNumber, &markerPoint);
+	YerFace_MutexLock(myMutex);
+	for(size_t faceIndex = 0; faceIndex < numFaces; faceIndex++) {
+		MarkerPoint *markerPoint = &framePoints[faceIndex];
+		markerPoint->set = false;
+		markerPoint->faceId = faceTracker->getFaceId(frameNumber, faceIndex);
 
-	calculate3dMarkerPoint(frameNumber, &markerPoint);
+		assignMarkerPoint(frameNumber, faceIndex, markerPoint);
 
-	WorkingFrame *workingFrame = frameServer->getWorkingFrame(frameNumber);
+		calculate3dMarkerPoint(frameNumber, faceIndex, markerPoint);
 
-	YerFace_MutexLock(myMutex);
-	performMarkerPointValidationAndSmoothing(workingFrame, frameNumber, &markerPoint);
+		performMarkerPointValidationAndSmoothing(workingFrame, frameNumber, markerPoint);
+	}
+
+	//Forget faces which have been gone long enough that their history would be thrown away anyway.
+	for(auto iterator = faceStates.begin(); iterator != faceStates.end();) {
+		if(workingFrame->frameTimestamps.startTimestamp - iterator->second.lastSeenTimestamp > pointSmoothingOverSeconds + markerRejectionResetAfterSeconds) {
+			iterator = faceStates.erase(iterator);
+		} else {
+			++iterator;
+		}
+	}
 
-	markerPoints[frameNumber] = markerPoint;
+	markerPoints[frameNumber] = framePoints;
 	YerFace_MutexUnlock(myMutex);
 }
 
-void MarkerTracker::assignMarkerPoint(FrameNumber frameNumber, MarkerPoint *markerPoint) {
-	FacialFeatures facialFeatures = faceTracker->getFacialFeatures(frameNumber);
+void MarkerTracker::assignMarkerPoint(FrameNumber frameNumber, size_t faceIndex, MarkerPoint *markerPoint) {
+	FacialFeatures facialFeatures = faceTracker->getFacialFeatures(frameNumber, faceIndex);
 	if(!facialFeatures.set) {
 		return;
 	}
@@ -239,31 +248,27 @@ void MarkerTracker::assignMarkerPoint(FrameNumber frameNumber, MarkerPoint *mark
 	}
 }
 
-void MarkerTracker::calculate3dMarkerPoint(FrameNumber frameNumber, MarkerPoint *markerPoint) {
+void MarkerTracker::calculate3dMarkerPoint(FrameNumber frameNumber, size_t faceIndex, MarkerPoint *markerPoint) {
 	if(!markerPoint->set) {
 		return;
 	}
-	FacialPose facialPose = faceTracker->getFacialPose(frameNumber);
+	FacialPose facialPose = faceTracker->getFacialPose(frameNumber, faceIndex);
 	FacialCameraModel cameraModel = faceTracker->getFacialCameraModel();
 	if(!facialPose.set || !cameraModel.set) {
 		markerPoint->set = false;
 		return;
 	}
-	FacialPlane facialPlane = faceTracker->getCalculatedFacialPlaneForWorkingFacialPose(frameNumber, markerType);
-	Mat homogeneousPoint = (Mat_<double>(3,1) << markerPoint->point.x, markerPoint->point.y, 1.0);
-	Mat worldPoint = cameraModel.cameraMatrix.inv() * homogeneousPoint;
+	FacialPlane facialPlane = faceTracker->getCalculatedFacialPlaneForWorkingFacialPose(frameNumber, markerType, faceIndex);
+	Vec3d rayVector = cameraModel.cameraMatrix.inv() * Vec3d(markerPoint->point.x, markerPoint->point.y, 1.0);
 	Point3d intersection;
 	Point3d rayOrigin = Point3d(0,0,0);
-	Vec3d rayVector = Vec3d(worldPoint.at<double>(0), worldPoint.at<double>(1), worldPoint.at<double>(2));
 	if(!Utilities::rayPlaneIntersection(intersection, rayOrigin, rayVector, facialPlane.planePoint, facialPlane.planeNormal)) {
 		logger->err("Failed 3d ray/plane intersection with face plane! No update to 3d marker point.");
 		return;
 	}
-	Mat markerMat = (Mat_<double>(3, 1) << intersection.x, intersection.y, intersection.z);
-	markerMat = markerMat - facialPose.translationVectorInternal;
-	markerMat = facialPose.rotationMatrixInternal.inv() * markerMat;
-	markerPoint->point3d = Point3d(markerMat.at<double>(0), markerMat.at<double>(1), markerMat.at<double>(2));
-	logger->debug4("Recovered approximate 3D position: <%.03f, %.03f, %.03f>", markerPoint->point3d.x, markerPoint->point3d.y, markerPoint->point3d.z);
+	Vec3d markerVector = facialPose.rotationMatrixInternal.inv() * (Vec3d(intersection) - facialPose.translationVectorInternal);
+	markerPoint->point3d = Point3d(markerVector);
+	YerFace_LogDebug4(logger, "Recovered approximate 3D position: <%.03f, %.03f, %.03f>", markerPoint->point3d.x, markerPoint->point3d.y, markerPoint->point3d.z);
 }
 
 void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *workingFrame, FrameNumber frameNumber, MarkerPoint *markerPoint) {
@@ -272,6 +277,8 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 	}
 
 	FrameTimestamps frameTimestamps = workingFrame->frameTimestamps;
+	MarkerTrackerFaceState *state = &faceStates[markerPoint->faceId];
+	state->lastSeenTimestamp = frameTimestamps.startTimestamp;
 	double timeScale = (double)(frameTimestamps.estimatedEndTimestamp - frameTimestamps.startTimestamp) / (double)(1.0 / 30.0);
 	double frameTimestamp = frameTimestamps.startTimestamp;
 	markerPoint->timestamp = frameTimestamps;
@@ -281,19 +288,19 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 	//// REJECT BAD MARKER POINTS ////
 
 	double distance;
-	if(previouslyReportedMarkerPoint.set) {
-		if(previouslyReportedMarkerPoint.timestamp.frameNumber >= frameTimestamps.frameNumber) {
+	if(state->previouslyReportedMarkerPoint.set) {
+		if(state->previouslyReportedMarkerPoint.timestamp.frameNumber >= frameTimestamps.frameNumber) {
 			logger->crit("MarkerTracker is being fed frames out of order! This will wreak havoc with smoothing code.");
 		}
 
-		distance = Utilities::lineDistance(markerPoint->point3d, previouslyReportedMarkerPoint.point3d);
+		distance = Utilities::lineDistance(markerPoint->point3d, state->previouslyReportedMarkerPoint.point3d);
 		if(distance > (pointMotionHighRejectionThreshold * timeScale)) {
 			logger->info("Dropping marker position due to high motion (%.02lf)!", distance);
-			if(markerPoint->timestamp.startTimestamp - previouslyReportedMarkerPoint.timestamp.startTimestamp >= markerRejectionResetAfterSeconds) {
-				logger->notice("Marker position has come back bad consistantly for %.02lf seconds! Unsetting the marker completely.", markerPoint->timestamp.startTimestamp - previouslyReportedMarkerPoint.timestamp.startTimestamp);
-				previouslyReportedMarkerPoint.set = false;
+			if(markerPoint->timestamp.startTimestamp - state->previouslyReportedMarkerPoint.timestamp.startTimestamp >= markerRejectionResetAfterSeconds) {
+				logger->notice("Marker position has come back bad consistantly for %.02lf seconds! Unsetting the marker completely.", markerPoint->timestamp.startTimestamp - state->previouslyReportedMarkerPoint.timestamp.startTimestamp);
+				state->previouslyReportedMarkerPoint.set = false;
 			}
-			*markerPoint = previouslyReportedMarkerPoint;
+			*markerPoint = state->previouslyReportedMarkerPoint;
 			YerFace_MutexUnlock(myMutex);
 			return;
 		}
@@ -301,9 +308,9 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 
 	//// PERFORM MARKER POINT SMOOTHING ////
 
-	markerPointSmoothingBuffer.push_back(*markerPoint);
-	while(markerPointSmoothingBuffer.front().timestamp.startTimestamp <= (frameTimestamp - pointSmoothingOverSeconds)) {
-		markerPointSmoothingBuffer.pop_front();
+	state->markerPointSmoothingBuffer.push_back(*markerPoint);
+	while(state->markerPointSmoothingBuffer.front().timestamp.startTimestamp <= (frameTimestamp - pointSmoothingOverSeconds)) {
+		state->markerPointSmoothingBuffer.pop_front();
 	}
 
 	MarkerPoint tempPoint = *markerPoint;
@@ -312,7 +319,7 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 	tempPoint.point3d.z = 0;
 
 	double combinedWeights = 0.0;
-	for(MarkerPoint point : markerPointSmoothingBuffer) {
+	for(MarkerPoint point : state->markerPointSmoothingBuffer) {
 		double progress = (point.timestamp.startTimestamp - (frameTimestamp - pointSmoothingOverSeconds)) / pointSmoothingOverSeconds;
 		double weight = std::pow(progress, (double)pointSmoothingExponent) - combinedWeights;
 		combinedWeights += weight;
@@ -324,8 +331,8 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 	//// REJECT NOISY UPDATES ////
 
 	bool reportNewPoint = true;
-	if(previouslyReportedMarkerPoint.set) {
-		distance = Utilities::lineDistance(tempPoint.point3d, previouslyReportedMarkerPoint.point3d);
+	if(state->previouslyReportedMarkerPoint.set) {
+		distance = Utilities::lineDistance(tempPoint.point3d, state->previouslyReportedMarkerPoint.point3d);
 		if(distance < (pointMotionLowRejectionThreshold * timeScale)) {
 			reportNewPoint = false;
 		}
@@ -333,9 +340,9 @@ void MarkerTracker::performMarkerPointValidationAndSmoothing(WorkingFrame *worki
 
 	if(reportNewPoint) {
 		*markerPoint = tempPoint;
-		previouslyReportedMarkerPoint = *markerPoint;
+		state->previouslyReportedMarkerPoint = *markerPoint;
 	} else {
-		*markerPoint = previouslyReportedMarkerPoint;
+		*markerPoint = state->previouslyReportedMarkerPoint;
 	}
 
 	YerFace_MutexUnlock(myMutex);
@@ -369,21 +376,27 @@ void MarkerTracker::renderPreviewHUD(Mat frame, FrameNumber frameNumber, int den
 		}
 	}
 	YerFace_MutexLock(myMutex);
-	if(density > 0 && markerPoints[frameNumber].set) {
-		cv::Point2d point = markerPoints[frameNumber].point;
-		if(mirrorMode) {
-			point.x = frame.size().width - point.x;
+	if(density > 0) {
+		for(MarkerPoint markerPoint : markerPoints[frameNumber]) {
+			if(!markerPoint.set) {
+				continue;
+			}
+			cv::Point2d point = markerPoint.point;
+			if(mirrorMode) {
+				point.x = frame.size().width - point.x;
+			}
+			Utilities::drawX(frame, point, color, 10, 2); // FIXME - proportional drawing
 		}
-		Utilities::drawX(frame, point, color, 10, 2); // FIXME - proportional drawing
 	}
 	YerFace_MutexUnlock(myMutex);
 }
 
 void MarkerTracker::frameStatusNew(FrameNumber frameNumber) {
 	MarkerPoint markerPoint;
+	markerPoint.faceId = -1;
 	markerPoint.set = false;
 	YerFace_MutexLock(myMutex);
-	markerPoints[frameNumber] = markerPoint;
+	markerPoints[frameNumber] = { markerPoint };
 	YerFace_MutexUnlock(myMutex);
 }
 
@@ -393,10 +406,15 @@ void MarkerTracker::frameStatusGone(FrameNumber frameNumber) {
 	YerFace_MutexUnlock(myMutex);
 }
 
-MarkerPoint MarkerTracker::getMarkerPoint(FrameNumber frameNumber) {
+MarkerPoint MarkerTracker::getMarkerPoint(FrameNumber frameNumber, size_t faceIndex) {
 	MarkerPoint val;
+	val.faceId = -1;
+	val.set = false;
 	YerFace_MutexLock(myMutex);
-	val = markerPoints[frameNumber];
+	std::vector<MarkerPoint> *framePoints = &markerPoints[frameNumber];
+	if(faceIndex < framePoints->size()) {
+		val = (*framePoints)[faceIndex];
+	}
 	YerFace_MutexUnlock(myMutex);
 	return val;
 }
@@ -3,6 +3,7 @@
 #include <string>
 #include <cstdlib>
 #include <list>
+#include <vector>
 
 #include "Logger.hpp"
 #include "SDLDriver.hpp"
@@ -21,9 +22,17 @@ public:
 	cv::Point2d point;
 	cv::Point3d point3d;
 	FrameTimestamps timestamp;
+	int faceId; //Matches FaceTrackerOutput::faceId.
 	bool set;
 };
 
+class MarkerTrackerFaceState {
+public:
+	list<MarkerPoint> markerPointSmoothingBuffer;
+	MarkerPoint previouslyReportedMarkerPoint;
+	double lastSeenTimestamp;
+};
+
 class FaceMapper;
 
 class MarkerTracker {
@@ -35,12 +44,12 @@ public:
 	void renderPreviewHUD(cv::Mat frame, FrameNumber frameNumber, int density, bool mirrorMode);
 	void frameStatusNew(FrameNumber frameNumber);
 	void frameStatusGone(FrameNumber frameNumber);
-	MarkerPoint getMarkerPoint(FrameNumber frameNumber);
+	MarkerPoint getMarkerPoint(FrameNumber frameNumber, size_t faceIndex = 0);
 	static vector<MarkerTracker *> getMarkerTrackers(void);
 	static MarkerTracker *getMarkerTrackerByType(MarkerType markerType);
 private:
-	void assignMarkerPoint(FrameNumber frameNumber, MarkerPoint *markerPoint);
-	void calculate3dMarkerPoint(FrameNumber frameNumber, MarkerPoint *markerPoint);
+	void assignMarkerPoint(FrameNumber frameNumber, size_t faceIndex, MarkerPoint *markerPoint);
+	void calculate3dMarkerPoint(FrameNumber frameNumber, size_t faceIndex, MarkerPoint *markerPoint);
 	void performMarkerPointValidationAndSmoothing(WorkingFrame *workingFrame, FrameNumber frameNumber, MarkerPoint *markerPoint);
 	
 	static vector<MarkerTracker *> markerTrackers;
@@ -59,9 +68,8 @@ private:
 	FaceTracker *faceTracker;
 
 	SDL_mutex *myMutex;
-	list<MarkerPoint> markerPointSmoothingBuffer;
-	MarkerPoint previouslyReportedMarkerPoint;
-	unordered_map<FrameNumber, MarkerPoint> markerPoints;
+	unordered_map<int, MarkerTrackerFaceState> faceStates; //Keyed by face ID.
+	unordered_map<FrameNumber, std::vector<MarkerPoint>> markerPoints; //One marker point per face, in FaceTracker order.
 };
 
 }; //namespace YerFace
@@ -0,0 +1,129 @@
+
+#include "MemoryGauge.hpp"
+#include "Utilities.hpp"
+
+#include <cinttypes>
+
+using namespace std;
+using namespace cv;
+
+namespace YerFace {
+
+SDL_mutex *MemoryGauge::gaugesMutex = SDL_CreateMutex();
+std::list<MemoryGauge *> MemoryGauge::gauges;
+
+MemoryGauge::MemoryGauge(const char *myName) {
+	name = (string)myName;
+	string loggerName = "MemoryGauge<" + name + ">";
+	logger = new Logger(loggerName.c_str());
+	if((myMutex = SDL_CreateMutex()) == NULL) {
+		throw runtime_error("Failed creating mutex!");
+	}
+	reading.name = name;
+	reading.bytes = 0;
+	reading.objects = 0;
+	reading.bytesHighWater = 0;
+	reading.objectsHighWater = 0;
+	lastHighWaterReport = 0.0;
+	highWaterReportPending = false;
+
+	YerFace_MutexLock(gaugesMutex);
+	gauges.push_back(this);
+	YerFace_MutexUnlock(gaugesMutex);
+
+	logger->debug1("MemoryGauge object constructed and ready to go!");
+}
+
+MemoryGauge::~MemoryGauge() noexcept(false) {
+	logger->debug1("MemoryGauge object destructing...");
+
+	YerFace_MutexLock(gaugesMutex);
+	gauges.remove(this);
+	YerFace_MutexUnlock(gaugesMutex);
+
+	YerFace_MutexLock(myMutex);
+	logger->debug1("FINAL REPORT: %s", getReadingStringInternal().c_str());
+	if(reading.bytes != 0 || reading.objects != 0) {
+		logger->warning("Gauge is not zero at destruction time! Something may have leaked.");
+	}
+	YerFace_MutexUnlock(myMutex);
+
+	SDL_DestroyMutex(myMutex);
+	delete logger;
+}
+
+void MemoryGauge::allocated(int64_t bytes, int64_t objects) {
+	YerFace_MutexLock(myMutex);
+	reading.bytes += bytes;
+	reading.objects += objects;
+	if(reading.bytes > reading.bytesHighWater) {
+		reading.bytesHighWater = reading.bytes;
+		highWaterReportPending = true;
+	}
+	if(reading.objects > reading.objectsHighWater) {
+		reading.objectsHighWater = reading.objects;
+		highWaterReportPending = true;
+	}
+
+	//A climbing high-water mark is how leaks (and undersized pools) show themselves, so report it. (But don't flood the log.)
+	if(highWaterReportPending) {
+		double now = (double)getTickCount() / (double)getTickFrequency();
+		if(lastHighWaterReport + MEMORYGAUGE_HIGHWATER_REPORT_INTERVAL_SECONDS <= now) {
+			logger->debug1("New High-Water Mark! %s", getReadingStringInternal().c_str());
+			lastHighWaterReport = now;
+			highWaterReportPending = false;
+		}
+	}
+	YerFace_MutexUnlock(myMutex);
+}
+
+void MemoryGauge::released(int64_t bytes, int64_t objects) {
+	YerFace_MutexLock(myMutex);
+	reading.bytes -= bytes;
+	reading.objects -= objects;
+	if(reading.bytes < 0 || reading.objects < 0) {
+		YerFace_MutexUnlock(myMutex);
+		throw logic_error("MemoryGauge released more than was allocated!");
+	}
+	YerFace_MutexUnlock(myMutex);
+}
+
+MemoryGaugeReading MemoryGauge::getReading(void) {
+	YerFace_MutexLock(myMutex);
+	MemoryGaugeReading myReading = reading;
+	YerFace_MutexUnlock(myMutex);
+	return myReading;
+}
+
+std::string MemoryGauge::getReadingString(void) {
+	YerFace_MutexLock(myMutex);
+	std::string str = getReadingStringInternal();
+	YerFace_MutexUnlock(myMutex);
+	return str;
+}
+
+std::string MemoryGauge::getReadingStringInternal(void) {
+	char readingString[256];
+	snprintf(readingString, sizeof(readingString), "Bytes: <Now %.02lfMiB, High %.02lfMiB>, Objects: <Now %" PRId64 ", High %" PRId64 ">", (double)reading.bytes / 1048576.0, (double)reading.bytesHighWater / 1048576.0, reading.objects, reading.objectsHighWater);
+	return (std::string)readingString;
+}
+
+std::list<MemoryGaugeReading> MemoryGauge::getAllReadings(void) {
+	std::list<MemoryGaugeReading> readings;
+	YerFace_MutexLock(gaugesMutex);
+	for(MemoryGauge *gauge : gauges) {
+		readings.push_back(gauge->getReading());
+	}
+	YerFace_MutexUnlock(gaugesMutex);
+	return readings;
+}
+
+void MemoryGauge::logAllReadings(Logger *logger, LogMessageSeverity severity) {
+	YerFace_MutexLock(gaugesMutex);
+	for(MemoryGauge *gauge : gauges) {
+		logger->log(severity, "%s: %s", gauge->name.c_str(), gauge->getReadingString().c_str());
+	}
+	YerFace_MutexUnlock(gaugesMutex);
+}
+
+} //namespace YerFace
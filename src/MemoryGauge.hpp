@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Logger.hpp"
+#include "Utilities.hpp"
+
+#include "SDL.h"
+
+#include "opencv2/core/utility.hpp"
+#include <list>
+
+using namespace std;
+
+namespace YerFace {
+
+#define MEMORYGAUGE_HIGHWATER_REPORT_INTERVAL_SECONDS 5.0
+
+class MemoryGaugeReading {
+public:
+	string name;
+	int64_t bytes, objects;
+	int64_t bytesHighWater, objectsHighWater;
+};
+
+// MemoryGauge tracks the number of bytes and the number of objects held by a
+// buffer pool (or similar), along with the high-water mark of each. All
+// MemoryGauges are registered globally so they can be reported on together.
+class MemoryGauge {
+public:
+	MemoryGauge(const char *myName);
+	~MemoryGauge() noexcept(false);
+	void allocated(int64_t bytes, int64_t objects = 1);
+	void released(int64_t bytes, int64_t objects = 1);
+	MemoryGaugeReading getReading(void);
+	std::string getReadingString(void);
+	static std::list<MemoryGaugeReading> getAllReadings(void);
+	static void logAllReadings(Logger *logger, LogMessageSeverity severity);
+private:
+	std::string getReadingStringInternal(void);
+
+	string name;
+	Logger *logger;
+	SDL_mutex *myMutex;
+	MemoryGaugeReading reading;
+	double lastHighWaterReport;
+	bool highWaterReportPending;
+
+	static SDL_mutex *gaugesMutex;
+	static std::list<MemoryGauge *> gauges;
+};
+
+}; //namespace YerFace
@@ -2,11 +2,16 @@
 #include "Metrics.hpp"
 #include "Utilities.hpp"
 
+#include <algorithm>
+
 using namespace std;
 using namespace cv;
 
 namespace YerFace {
 
+SDL_mutex *Metrics::allMetricsMutex = SDL_CreateMutex();
+std::list<Metrics *> Metrics::allMetrics;
+
 Metrics::Metrics(json config, const char *myName, bool myMetricIsFrames) {
 	name = (string)myName;
 	metricIsFrames = myMetricIsFrames;
@@ -18,22 +23,36 @@ Metrics::Metrics(json config, const char *myName, bool myMetricIsFrames) {
 	if(averageOverSeconds < 1.0) {
 		throw invalid_argument("reportEverySeconds cannot be less than one");
 	}
+	hardwareCountersEnabled = config["YerFace"]["Metrics"]["hardwareCountersEnabled"];
 	lastReport = 0.0;
 	averageTimeSeconds = 0.0;
 	worstTimeSeconds = 0.0;
 	fps = 0.0;
+	hardwareCountersSet = false;
+	instructionsPerCycle = 0.0;
+	cacheMissesPerTick = 0.0;
+	branchMissesPerTick = 0.0;
 	snprintf(timesString, METRICS_STRING_LENGTH, "N/A");
 	snprintf(fpsString, METRICS_STRING_LENGTH, "N/A");
+	snprintf(hardwareCountersString, METRICS_STRING_LENGTH, "N/A");
 	string loggerName = "Metrics<" + name + ">";
 	logger = new Logger(loggerName.c_str());
 	if((myMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
+
+	YerFace_MutexLock(allMetricsMutex);
+	allMetrics.push_back(this);
+	YerFace_MutexUnlock(allMetricsMutex);
+
 	logger->debug1("Metrics object constructed and ready to go!");
 }
 
 Metrics::~Metrics() noexcept(false) {
 	logger->debug1("Metrics object destructing...");
+	YerFace_MutexLock(allMetricsMutex);
+	allMetrics.remove(this);
+	YerFace_MutexUnlock(allMetricsMutex);
 	logReportNow("FINAL REPORT: ");
 	SDL_DestroyMutex(myMutex);
 	delete logger;
@@ -42,10 +61,17 @@ Metrics::~Metrics() noexcept(false) {
 MetricsTick Metrics::startClock(void) {
 	MetricsTick tick;
 	tick.startTime = (double)getTickCount() / (double)getTickFrequency();
+	tick.counters.valid = false;
+	if(hardwareCountersEnabled) {
+		tick.counters = HardwareCounters::sample();
+	}
 	return tick;
 }
 
 void Metrics::endClock(MetricsTick tick, bool verbose) {
+	if(hardwareCountersEnabled) {
+		tick.counters = HardwareCounters::difference(HardwareCounters::sample(), tick.counters);
+	}
 	double now = (double)getTickCount() / (double)getTickFrequency();
 	tick.runTime = now - tick.startTime;
 
@@ -64,11 +90,27 @@ void Metrics::endClock(MetricsTick tick, bool verbose) {
 	averageTimeSeconds = 0.0;
 	worstTimeSeconds = 0.0;
 	size_t numEntries = entries.size();
+	uint64_t totalCycles = 0, totalInstructions = 0, totalCacheMisses = 0, totalBranchMisses = 0;
+	size_t numCounterEntries = 0;
 	for(MetricsTick entry : entries) {
 		averageTimeSeconds = averageTimeSeconds + entry.runTime;
 		if(entry.runTime > worstTimeSeconds) {
 			worstTimeSeconds = entry.runTime;
 		}
+		if(entry.counters.valid) {
+			totalCycles += entry.counters.cycles;
+			totalInstructions += entry.counters.instructions;
+			totalCacheMisses += entry.counters.cacheMisses;
+			totalBranchMisses += entry.counters.branchMisses;
+			numCounterEntries++;
+		}
+	}
+	if(numCounterEntries > 0 && totalCycles > 0) {
+		hardwareCountersSet = true;
+		instructionsPerCycle = (double)totalInstructions / (double)totalCycles;
+		cacheMissesPerTick = (double)totalCacheMisses / (double)numCounterEntries;
+		branchMissesPerTick = (double)totalBranchMisses / (double)numCounterEntries;
+		snprintf(hardwareCountersString, METRICS_STRING_LENGTH, "Counters: <IPC %.02f, Cache Misses %.0f, Branch Misses %.0f> per %s", instructionsPerCycle, cacheMissesPerTick, branchMissesPerTick, metricIsFrames ? "frame" : "task");
 	}
 	averageTimeSeconds = averageTimeSeconds / (double)numEntries;
 	snprintf(timesString, METRICS_STRING_LENGTH, "Times: <Avg %.02fms, Worst %.02fms>", averageTimeSeconds * 1000.0, worstTimeSeconds * 1000.0);
@@ -94,7 +136,11 @@ void Metrics::endClock(MetricsTick tick, bool verbose) {
 }
 
 void Metrics::logReportNow(string prefix) {
-	logger->debug1("%s%s, %s", prefix.c_str(), fpsString, timesString);
+	if(hardwareCountersSet) {
+		logger->debug1("%s%s, %s, %s", prefix.c_str(), fpsString, timesString, hardwareCountersString);
+	} else {
+		logger->debug1("%s%s, %s", prefix.c_str(), fpsString, timesString);
+	}
 }
 
 double Metrics::getAverageTimeSeconds(void) {
@@ -132,4 +178,58 @@ std::string Metrics::getFPSString(void) {
 	return str;
 }
 
+std::string Metrics::getHardwareCountersString(void) {
+	YerFace_MutexLock(myMutex);
+	std::string str = (std::string)hardwareCountersString;
+	YerFace_MutexUnlock(myMutex);
+	return str;
+}
+
+MetricsReading Metrics::getReading(void) {
+	MetricsReading reading;
+	reading.name = name;
+	reading.metricIsFrames = metricIsFrames;
+
+	YerFace_MutexLock(myMutex);
+	reading.numSamples = entries.size();
+	reading.fps = fps;
+	reading.averageTimeSeconds = averageTimeSeconds;
+	reading.worstTimeSeconds = worstTimeSeconds;
+	reading.hardwareCountersSet = hardwareCountersSet;
+	reading.instructionsPerCycle = instructionsPerCycle;
+	reading.cacheMissesPerTick = cacheMissesPerTick;
+	reading.branchMissesPerTick = branchMissesPerTick;
+	vector<double> sortedRunTimes;
+	sortedRunTimes.reserve(entries.size());
+	for(MetricsTick entry : entries) {
+		sortedRunTimes.push_back(entry.runTime);
+	}
+	YerFace_MutexUnlock(myMutex);
+
+	//Percentiles are only computed on demand, so that endClock() stays cheap.
+	std::sort(sortedRunTimes.begin(), sortedRunTimes.end());
+	reading.p50TimeSeconds = getPercentileTimeSecondsInternal(&sortedRunTimes, 0.50);
+	reading.p90TimeSeconds = getPercentileTimeSecondsInternal(&sortedRunTimes, 0.90);
+	reading.p99TimeSeconds = getPercentileTimeSecondsInternal(&sortedRunTimes, 0.99);
+	return reading;
+}
+
+double Metrics::getPercentileTimeSecondsInternal(vector<double> *sortedRunTimes, double percentile) {
+	if(sortedRunTimes->size() < 1) {
+		return 0.0;
+	}
+	size_t index = (size_t)(percentile * (double)(sortedRunTimes->size() - 1) + 0.5);
+	return (*sortedRunTimes)[index];
+}
+
+std::list<MetricsReading> Metrics::getAllReadings(void) {
+	std::list<MetricsReading> readings;
+	YerFace_MutexLock(allMetricsMutex);
+	for(Metrics *metrics : allMetrics) {
+		readings.push_back(metrics->getReading());
+	}
+	YerFace_MutexUnlock(allMetricsMutex);
+	return readings;
+}
+
 } //namespace YerFace
@@ -2,11 +2,13 @@
 
 #include "Logger.hpp"
 #include "Utilities.hpp"
+#include "HardwareCounters.hpp"
 
 #include "SDL.h"
 
 #include "opencv2/core/utility.hpp"
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -18,6 +20,19 @@ class MetricsTick {
 public:
 	double startTime;
 	double runTime;
+	HardwareCounterSample counters;
+};
+
+class MetricsReading {
+public:
+	string name;
+	bool metricIsFrames;
+	size_t numSamples;
+	double fps;
+	double averageTimeSeconds, worstTimeSeconds;
+	double p50TimeSeconds, p90TimeSeconds, p99TimeSeconds;
+	bool hardwareCountersSet;
+	double instructionsPerCycle, cacheMissesPerTick, branchMissesPerTick;
 };
 
 class FrameServer;
@@ -33,11 +48,16 @@ public:
 	double getFPS(void);
 	std::string getTimesString(void);
 	std::string getFPSString(void);
+	std::string getHardwareCountersString(void);
+	MetricsReading getReading(void);
+	static std::list<MetricsReading> getAllReadings(void);
 private:
 	void logReportNow(string prefix);
+	double getPercentileTimeSecondsInternal(vector<double> *sortedRunTimes, double percentile);
 
 	string name;
 	bool metricIsFrames;
+	bool hardwareCountersEnabled;
 	double averageOverSeconds, reportEverySeconds;
 	double lastReport;
 
@@ -47,7 +67,12 @@ private:
 	double averageTimeSeconds;
 	double worstTimeSeconds;
 	double fps;
-	char timesString[METRICS_STRING_LENGTH], fpsString[METRICS_STRING_LENGTH];
+	bool hardwareCountersSet;
+	double instructionsPerCycle, cacheMissesPerTick, branchMissesPerTick;
+	char timesString[METRICS_STRING_LENGTH], fpsString[METRICS_STRING_LENGTH], hardwareCountersString[METRICS_STRING_LENGTH];
+
+	static SDL_mutex *allMetricsMutex;
+	static std::list<Metrics *> allMetrics;
 };
 
 }; //namespace YerFace
@@ -135,6 +135,7 @@ public:
 	void serverOnClose(websocketpp::connection_hdl handle);
 	void serverOnTimer(websocketpp::lib::error_code const &ec);
 	void serverSetQuitPollTimer(void);
+	void serverPublishPerfTelemetry(void);
 
 	OutputDriver *parent;
 
@@ -145,6 +146,10 @@ public:
 	std::set<websocketpp::connection_hdl,std::owner_less<websocketpp::connection_hdl>> connectionList;
 	bool websocketServerRunning;
 
+	bool perfTelemetryEnabled;
+	double perfTelemetryIntervalSeconds;
+	double perfTelemetryLastPublished;
+
 	SDL_Thread *serverThread;
 };
 
@@ -161,7 +166,7 @@ bool OutputFrameContainer::isReady(void) {
 	return true;
 }
 
-OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver) {
+OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FFmpegDriver *myFFmpegDriver, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver) {
 	workerPool = NULL;
 	outputFilename = myOutputFilename;
 	rawEventsPending.clear();
@@ -173,10 +178,18 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	if(frameServer == NULL) {
 		throw invalid_argument("frameServer cannot be NULL");
 	}
+	ffmpegDriver = myFFmpegDriver;
+	if(ffmpegDriver == NULL) {
+		throw invalid_argument("ffmpegDriver cannot be NULL");
+	}
 	faceTracker = myFaceTracker;
 	if(faceTracker == NULL) {
 		throw invalid_argument("faceTracker cannot be NULL");
 	}
+	multipleFacesEnabled = (int)config["YerFace"]["FaceDetector"]["maxFaces"] > 1;
+	faceForgetAfterSeconds = config["YerFace"]["FaceDetector"]["faceForgetAfterSeconds"];
+	primaryFaceId = -1;
+	primaryFaceLastSeenTimestamp = 0.0;
 	sdlDriver = mySDLDriver;
 	if(sdlDriver == NULL) {
 		throw invalid_argument("sdlDriver cannot be NULL");
@@ -191,6 +204,7 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	if((rawEventsMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
+	pendingFramesGauge = new MemoryGauge("OutputDriver.PendingFrames");
 
 	//We need to know when the frame server has drained.
 	frameServerDrained = false;
@@ -271,6 +285,12 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 		throw runtime_error("Server port is invalid");
 	}
 	webSocketServer->websocketServerEnabled = config["YerFace"]["OutputDriver"]["websocketServerEnabled"];
+	webSocketServer->perfTelemetryEnabled = config["YerFace"]["OutputDriver"]["perfTelemetryEnabled"];
+	webSocketServer->perfTelemetryIntervalSeconds = config["YerFace"]["OutputDriver"]["perfTelemetryIntervalSeconds"];
+	if(webSocketServer->perfTelemetryIntervalSeconds < 0.1) {
+		throw invalid_argument("perfTelemetryIntervalSeconds cannot be less than 0.1");
+	}
+	webSocketServer->perfTelemetryLastPublished = 0.0;
 
 	//Constrain websocket server logs a bit for sanity.
 	webSocketServer->server.get_alog().clear_channels(log::alevel::all);
@@ -305,6 +325,12 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	//We also want to introduce a checkpoint so that frames cannot TRANSITION AWAY from FRAME_STATUS_DRAINING without our blessing.
 	frameServer->registerFrameStatusCheckpoint(FRAME_STATUS_DRAINING, "outputDriver.ran");
 
@@ -324,6 +350,9 @@ OutputDriver::OutputDriver(json config, string myOutputFilename, Status *myStatu
 OutputDriver::~OutputDriver() noexcept(false) {
 	logger->debug1("OutputDriver object destructing...");
 
+	frameServer->removeFrameServerDrainedEvent((void *)this);
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	delete workerPool;
 
 	YerFace_MutexLock(workerMutex);
@@ -331,6 +360,7 @@ OutputDriver::~OutputDriver() noexcept(false) {
 		logger->err("Frames are still pending! Woe is me!");
 	}
 	YerFace_MutexUnlock(workerMutex);
+	delete pendingFramesGauge;
 
 	if(webSocketServer->websocketServerEnabled && webSocketServer->serverThread) {
 		YerFace_MutexLock(webSocketServer->websocketMutex);
@@ -423,30 +453,46 @@ void OutputDriver::handleOutputFrame(OutputFrameContainer *outputFrame) {
 		outputFrame->frame["meta"]["basis"] = false;
 	}
 
-	bool allPropsSet = true;
-	FacialPose facialPose = faceTracker->getFacialPose(outputFrame->frameTimestamps.frameNumber);
-	if(facialPose.set) {
-		outputFrame->frame["pose"] = json::object();
-		Vec3d angles = Utilities::rotationMatrixToEulerAngles(facialPose.rotationMatrix);
-		outputFrame->frame["pose"]["rotation"] = { {"x", angles[0]}, {"y", angles[1]}, {"z", angles[2]} };
-		outputFrame->frame["pose"]["translation"] = { {"x", facialPose.translationVector.at<double>(0)}, {"y", facialPose.translationVector.at<double>(1)}, {"z", facialPose.translationVector.at<double>(2)} };
+	//The primary face keeps the top level "pose" and "trackers" keys, and is the only face which drives the automatic basis.
+	FrameNumber frameNumber = outputFrame->frameTimestamps.frameNumber;
+	bool allPropsSet;
+	if(!multipleFacesEnabled) {
+		allPropsSet = doFillFaceData(frameNumber, 0, &outputFrame->frame);
 	} else {
-		allPropsSet = false;
-	}
-
-	json trackers;
-	auto markerTrackers = MarkerTracker::getMarkerTrackers();
-	for(auto markerTracker : markerTrackers) {
-		MarkerPoint markerPoint = markerTracker->getMarkerPoint(outputFrame->frameTimestamps.frameNumber);
-		if(markerPoint.set) {
-			string trackerName = markerTracker->getMarkerType().toString();
-			trackers[trackerName.c_str()]["position"] = { {"x", markerPoint.point3d.x}, {"y", markerPoint.point3d.y}, {"z", markerPoint.point3d.z} };
+		//Face order changes with face size, so the primary face is pinned to one face ID until the detector would have forgotten it.
+		double frameTimestamp = outputFrame->frameTimestamps.startTimestamp;
+		size_t numFaces = faceTracker->getNumFaces(frameNumber);
+		bool primaryFacePresent = false;
+		size_t primaryFaceIndex = 0;
+		for(size_t faceIndex = 0; faceIndex < numFaces; faceIndex++) {
+			if(primaryFaceId >= 0 && faceTracker->getFaceId(frameNumber, faceIndex) == primaryFaceId) {
+				primaryFacePresent = true;
+				primaryFaceIndex = faceIndex;
+			}
+		}
+		if(!primaryFacePresent && (primaryFaceId < 0 || frameTimestamp - primaryFaceLastSeenTimestamp > faceForgetAfterSeconds)) {
+			primaryFaceId = faceTracker->getFaceId(frameNumber, 0);
+			primaryFacePresent = primaryFaceId >= 0;
+			primaryFaceIndex = 0;
+		}
+		if(primaryFacePresent) {
+			primaryFaceLastSeenTimestamp = frameTimestamp;
+			allPropsSet = doFillFaceData(frameNumber, primaryFaceIndex, &outputFrame->frame);
 		} else {
 			allPropsSet = false;
 		}
-	}
-	if(trackers.size()) {
-		outputFrame->frame["trackers"] = trackers;
+
+		json faces = json::object();
+		for(size_t faceIndex = 0; faceIndex < numFaces; faceIndex++) {
+			int faceId = faceTracker->getFaceId(frameNumber, faceIndex);
+			if(faceId < 0) {
+				continue;
+			}
+			json face = json::object();
+			doFillFaceData(frameNumber, faceIndex, &face);
+			faces[to_string(faceId)] = face;
+		}
+		outputFrame->frame["faces"] = faces;
 	}
 
 	YerFace_MutexLock(this->basisMutex);
@@ -464,6 +510,35 @@ void OutputDriver::handleOutputFrame(OutputFrameContainer *outputFrame) {
 	outputNewFrame(outputFrame->frame);
 }
 
+bool OutputDriver::doFillFaceData(FrameNumber frameNumber, size_t faceIndex, json *face) {
+	bool allPropsSet = true;
+	FacialPose facialPose = faceTracker->getFacialPose(frameNumber, faceIndex);
+	if(facialPose.set) {
+		(*face)["pose"] = json::object();
+		Vec3d angles = Utilities::rotationMatrixToEulerAngles(facialPose.rotationMatrix);
+		(*face)["pose"]["rotation"] = { {"x", angles[0]}, {"y", angles[1]}, {"z", angles[2]} };
+		(*face)["pose"]["translation"] = { {"x", facialPose.translationVector[0]}, {"y", facialPose.translationVector[1]}, {"z", facialPose.translationVector[2]} };
+	} else {
+		allPropsSet = false;
+	}
+
+	json trackers;
+	auto markerTrackers = MarkerTracker::getMarkerTrackers();
+	for(auto markerTracker : markerTrackers) {
+		MarkerPoint markerPoint = markerTracker->getMarkerPoint(frameNumber, faceIndex);
+		if(markerPoint.set) {
+			string trackerName = markerTracker->getMarkerType().toString();
+			trackers[trackerName.c_str()]["position"] = { {"x", markerPoint.point3d.x}, {"y", markerPoint.point3d.y}, {"z", markerPoint.point3d.z} };
+		} else {
+			allPropsSet = false;
+		}
+	}
+	if(trackers.size()) {
+		(*face)["trackers"] = trackers;
+	}
+	return allPropsSet;
+}
+
 void OutputDriver::registerFrameData(string key) {
 	YerFace_MutexLock(workerMutex);
 	lateFrameWaitOn.push_back(key);
@@ -511,6 +586,59 @@ void OutputDriver::outputNewFrame(json frame) {
 	}
 }
 
+json OutputDriver::getPerfTelemetryPacket(void) {
+	json perf = json::object();
+	perf["fps"] = nullptr;
+	perf["latency"] = nullptr;
+	perf["stages"] = json::object();
+	for(MetricsReading reading : Metrics::getAllReadings()) {
+		json latency = {
+			{ "averageMs", reading.averageTimeSeconds * 1000.0 },
+			{ "p50Ms", reading.p50TimeSeconds * 1000.0 },
+			{ "p90Ms", reading.p90TimeSeconds * 1000.0 },
+			{ "p99Ms", reading.p99TimeSeconds * 1000.0 },
+			{ "worstMs", reading.worstTimeSeconds * 1000.0 }
+		};
+		perf["stages"][reading.name] = {
+			{ "rate", reading.fps },
+			{ "samples", reading.numSamples },
+			{ "latency", latency }
+		};
+		if(reading.hardwareCountersSet) {
+			perf["stages"][reading.name]["counters"] = {
+				{ "instructionsPerCycle", reading.instructionsPerCycle },
+				{ "cacheMisses", reading.cacheMissesPerTick },
+				{ "branchMisses", reading.branchMissesPerTick }
+			};
+		}
+		//The top level "YerFace" metric times each frame from NEW to GONE, so it describes the whole pipeline.
+		if(reading.name == "YerFace") {
+			perf["fps"] = reading.fps;
+			perf["latency"] = latency;
+		}
+	}
+
+	perf["queues"] = json::object();
+	for(MemoryGaugeReading reading : MemoryGauge::getAllReadings()) {
+		perf["queues"][reading.name] = {
+			{ "depth", reading.objects },
+			{ "highWater", reading.objectsHighWater }
+		};
+	}
+
+	perf["dropped"] = {
+		{ "ffmpegLowLatency", ffmpegDriver->getVideoFramesDroppedCount() }
+	};
+
+	//Telemetry is out-of-band, so it gets the same "no frame" meta values as a replayed basis event.
+	json packet = json::object();
+	packet["meta"]["frameNumber"] = -1;
+	packet["meta"]["startTime"] = -1.0;
+	packet["meta"]["basis"] = false;
+	packet["meta"]["perf"] = perf;
+	return packet;
+}
+
 bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 	OutputDriver *self = (OutputDriver *)worker->ptr;
 
@@ -532,7 +660,7 @@ bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 		outputFrame = &self->pendingFrames[myFrameNumber];
 	}
 	if(outputFrame != NULL && !outputFrame->isReady()) {
-		self->logger->debug4("BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
+		YerFace_LogDebug4(self->logger, "BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 		myFrameNumber = -1;
 		outputFrame = NULL;
 	}
@@ -540,7 +668,7 @@ bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(outputFrame != NULL) {
-		self->logger->debug4("Output Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, outputFrame->frameTimestamps.frameNumber);
+		YerFace_LogDebug4(self->logger, "Output Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, outputFrame->frameTimestamps.frameNumber);
 
 		if(outputFrame->frameTimestamps.frameNumber <= lastFrameNumber) {
 			throw logic_error("OutputDriver handling frames out of order!");
@@ -560,6 +688,34 @@ bool OutputDriver::workerHandler(WorkerPoolWorker *worker) {
 	return didWork;
 }
 
+void OutputDriver::handleFrameServerStallEvent(void *userdata) {
+	OutputDriver *self = (OutputDriver *)userdata;
+	YerFace_MutexLock(self->workerMutex);
+	size_t pendingDepth = self->pendingFrames.size();
+	FrameNumber oldestFrameNumber = -1;
+	for(auto pendingFramePair : self->pendingFrames) {
+		if(!pendingFramePair.second.outputProcessed && (oldestFrameNumber < 0 || pendingFramePair.first < oldestFrameNumber)) {
+			oldestFrameNumber = pendingFramePair.first;
+		}
+	}
+	string waitingOn = "";
+	if(oldestFrameNumber >= 0) {
+		for(auto waitOnIter : self->pendingFrames[oldestFrameNumber].waitingOn.items()) {
+			if(waitOnIter.value()) {
+				waitingOn += (waitingOn.length() > 0 ? ", " : "") + waitOnIter.key();
+			}
+		}
+	}
+	YerFace_MutexUnlock(self->workerMutex);
+	YerFace_MutexLock(self->rawEventsMutex);
+	size_t rawEventsDepth = self->rawEventsPending.size();
+	YerFace_MutexUnlock(self->rawEventsMutex);
+	self->logger->warning("... Queue depths: <Pending Frames: %lu, Raw Events: %lu>", pendingDepth, rawEventsDepth);
+	if(oldestFrameNumber >= 0) {
+		self->logger->warning("... Oldest unprocessed frame #" YERFACE_FRAMENUMBER_FORMAT " is waiting on: [%s]", oldestFrameNumber, waitingOn.c_str());
+	}
+}
+
 void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
 	OutputDriver *self = (OutputDriver *)userdata;
@@ -571,7 +727,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 		default:
 			throw logic_error("Handler passed unsupported frame status change event!");
 		case FRAME_STATUS_NEW:
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " appearing as new! Queue depth is now %lu", frameNumber, self->pendingFrames.size());
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " appearing as new! Queue depth is now %lu", frameNumber, self->pendingFrames.size());
 			newOutputFrame.frame = json::object();
 			newOutputFrame.outputProcessed = false;
 			newOutputFrame.frameIsDraining = false;
@@ -584,6 +740,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 				newOutputFrame.waitingOn[waitOn] = true;
 			}
 			self->pendingFrames[frameNumber] = newOutputFrame;
+			self->pendingFramesGauge->allocated(0);
 			YerFace_MutexUnlock(self->workerMutex);
 			break;
 		case FRAME_STATUS_PREVIEW_DISPLAY:
@@ -626,7 +783,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			break;
 		case FRAME_STATUS_DRAINING:
 			YerFace_MutexLock(self->workerMutex);
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->pendingFrames.size());
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on me. Queue depth is now %lu", frameNumber, self->pendingFrames.size());
 			self->pendingFrames[frameNumber].frameIsDraining = true;
 			YerFace_MutexUnlock(self->workerMutex);
 			if(self->workerPool != NULL) {
@@ -639,6 +796,7 @@ void OutputDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 				throw logic_error("Frame is gone, but not yet processed!");
 			}
 			self->pendingFrames.erase(frameNumber);
+			self->pendingFramesGauge->released(0);
 			YerFace_MutexUnlock(self->workerMutex);
 			break;
 	}
@@ -708,10 +866,41 @@ void OutputDriverWebSocketServer::serverOnTimer(websocketpp::lib::error_code con
 	}
 	YerFace_MutexUnlock(websocketMutex);
 	if(continueTimer) {
+		serverPublishPerfTelemetry();
 		serverSetQuitPollTimer();
 	}
 }
 
+void OutputDriverWebSocketServer::serverPublishPerfTelemetry(void) {
+	if(!perfTelemetryEnabled) {
+		return;
+	}
+	double now = (double)getTickCount() / (double)getTickFrequency();
+	if(perfTelemetryLastPublished + perfTelemetryIntervalSeconds > now) {
+		return;
+	}
+	perfTelemetryLastPublished = now;
+
+	YerFace_MutexLock(websocketMutex);
+	bool haveConnections = connectionList.size() > 0;
+	YerFace_MutexUnlock(websocketMutex);
+	if(!haveConnections) {
+		return;
+	}
+
+	string jsonString = parent->getPerfTelemetryPacket().dump(-1, ' ', true);
+
+	YerFace_MutexLock(websocketMutex);
+	try {
+		for(auto handle : connectionList) {
+			server.send(handle, jsonString, websocketpp::frame::opcode::text);
+		}
+	} catch (websocketpp::exception const &e) {
+		parent->logger->err("Got a websocket exception: %s", e.what());
+	}
+	YerFace_MutexUnlock(websocketMutex);
+}
+
 void OutputDriverWebSocketServer::serverSetQuitPollTimer(void) {
 	server.set_timer(100, websocketpp::lib::bind(&OutputDriverWebSocketServer::serverOnTimer,this,::_1));
 }
@@ -2,6 +2,7 @@
 
 #include "Logger.hpp"
 #include "FrameServer.hpp"
+#include "FFmpegDriver.hpp"
 #include "FaceTracker.hpp"
 #include "MarkerTracker.hpp"
 #include "SDLDriver.hpp"
@@ -9,6 +10,7 @@
 #include "Utilities.hpp"
 #include "Status.hpp"
 #include "WorkerPool.hpp"
+#include "MemoryGauge.hpp"
 
 #include <set>
 
@@ -42,7 +44,7 @@ class OutputDriver {
 friend class OutputDriverWebSocketServer;
 
 public:
-	OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver);
+	OutputDriver(json config, string myOutputFilename, Status *myStatus, FrameServer *myFrameServer, FFmpegDriver *myFFmpegDriver, FaceTracker *myFaceTracker, SDLDriver *mySDLDriver);
 	~OutputDriver() noexcept(false);
 	void setEventLogger(EventLogger *myEventLogger);
 	void registerFrameData(string key);
@@ -50,15 +52,22 @@ public:
 private:
 	void handleNewBasisEvent(FrameNumber frameNumber);
 	void handleOutputFrame(OutputFrameContainer *outputFrame);
+	bool doFillFaceData(FrameNumber frameNumber, size_t faceIndex, json *face);
 	void outputNewFrame(json frame);
+	json getPerfTelemetryPacket(void);
 	static bool workerHandler(WorkerPoolWorker *worker);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static void handleFrameServerDrainedEvent(void *userdata);
 
 	string outputFilename;
 	Status *status;
 	FrameServer *frameServer;
+	FFmpegDriver *ffmpegDriver;
 	FaceTracker *faceTracker;
+	bool multipleFacesEnabled; //When the detector may report several faces, every face is also output under "faces", keyed by face ID.
+	int primaryFaceId; //The face behind the top level "pose" and "trackers" keys. Only touched by the (in order) output worker.
+	double primaryFaceLastSeenTimestamp, faceForgetAfterSeconds;
 	SDLDriver *sdlDriver;
 	EventLogger *eventLogger;
 	Logger *logger;
@@ -76,6 +85,7 @@ private:
 	SDL_mutex *workerMutex;
 	list<string> lateFrameWaitOn;
 	unordered_map<FrameNumber, OutputFrameContainer> pendingFrames;
+	MemoryGauge *pendingFramesGauge; //Counts pending frames only. Measuring the JSON would mean serializing it.
 	bool frameServerDrained;
 
 	SDL_mutex *rawEventsMutex;
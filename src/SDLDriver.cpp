@@ -30,6 +30,7 @@ SDLDriver::SDLDriver(json config, Status *myStatus, FrameServer *myFrameServer,
 	if((frameTimestampsNowMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
+	audioFramesGauge = new MemoryGauge("SDLDriver.AudioFrames");
 
 	frameTimestampsNow.startTimestamp = 0.0;
 	frameTimestampsNow.estimatedEndTimestamp = 0.0;
@@ -187,8 +188,10 @@ SDLDriver::~SDLDriver() noexcept(false) {
 		if(audioFrame->buf != NULL) {
 			av_freep(&audioFrame->buf);
 		}
+		audioFramesGauge->released(audioFrame->bufferSize);
 		delete audioFrame;
 	}
+	delete audioFramesGauge;
 	delete logger;
 }
 
@@ -372,7 +375,7 @@ void SDLDriver::doHandleEvents(void) {
 					if(buttonHeldSeconds < 0.0) {
 						buttonHeldSeconds = 0.0;
 					}
-					logger->debug4("Released button was held for %.02f seconds.", buttonHeldSeconds);
+					YerFace_LogDebug4(logger, "Released button was held for %.02f seconds.", buttonHeldSeconds);
 				}
 
 				if(joystickEventsRaw) {
@@ -467,10 +470,12 @@ SDLAudioFrame *SDLDriver::getNextAvailableAudioFrame(int desiredBufferSize) {
 			if(audioFrame->bufferSize < desiredBufferSize) {
 				//Not using realloc because it does not support guaranteed buffer alignment.
 				av_freep(&audioFrame->buf);
+				audioFramesGauge->released(audioFrame->bufferSize, 0);
 				if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
 					throw runtime_error("unable to allocate memory for audio frame");
 				}
 				audioFrame->bufferSize = desiredBufferSize;
+				audioFramesGauge->allocated(audioFrame->bufferSize, 0);
 			}
 			audioFrame->pos = 0;
 			audioFrame->inUse = true;
@@ -485,6 +490,8 @@ SDLAudioFrame *SDLDriver::getNextAvailableAudioFrame(int desiredBufferSize) {
 	audioFrame->bufferSize = desiredBufferSize;
 	audioFrame->pos = 0;
 	audioFrame->inUse = true;
+	audioFramesAllocated.push_front(audioFrame);
+	audioFramesGauge->allocated(audioFrame->bufferSize);
 	YerFace_MutexUnlock(audioFramesMutex);
 	return audioFrame;
 }
@@ -499,15 +506,15 @@ void SDLDriver::SDLAudioCallback(void* userdata, Uint8* stream, int len) {
 	YerFace_MutexLock(self->audioFramesMutex);
 	int streamPos = 0;
 	int frameDiscards = 0, frameFills = 0;
-	self->logger->debug4("SDL Audio Device Callback Fired");
+	YerFace_LogDebug4(self->logger, "SDL Audio Device Callback Fired");
 
 	while(len - streamPos > 0) {
 		int remaining = len - streamPos;
-		self->logger->debug4("Audio Callback Buffer Filling Loop... Length: %d, streamPos: %d, Remaining: %d, Frame Start: %lf, Frame End: %lf", len, streamPos, remaining, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
+		YerFace_LogDebug4(self->logger, "Audio Callback Buffer Filling Loop... Length: %d, streamPos: %d, Remaining: %d, Frame Start: %lf, Frame End: %lf", len, streamPos, remaining, frameTimestamps.startTimestamp, frameTimestamps.estimatedEndTimestamp);
 
 		double audioLateGraceTimestamp = frameTimestamps.startTimestamp - YERFACE_AUDIO_LATE_GRACE;
 		while(self->audioFrameQueue.size() > 0 && self->audioFrameQueue.back()->timestamp < audioLateGraceTimestamp) {
-			self->logger->debug4("AUDIO IS LATE! (Video Frame Start Time: %.04lf, Audio Frame Start Time: %.04lf, Grace Period: %.04lf) Discarding one audio frame.", frameTimestamps.startTimestamp, self->audioFrameQueue.back()->timestamp, YERFACE_AUDIO_LATE_GRACE);
+			YerFace_LogDebug4(self->logger, "AUDIO IS LATE! (Video Frame Start Time: %.04lf, Audio Frame Start Time: %.04lf, Grace Period: %.04lf) Discarding one audio frame.", frameTimestamps.startTimestamp, self->audioFrameQueue.back()->timestamp, YERFACE_AUDIO_LATE_GRACE);
 			self->audioFrameQueue.back()->inUse = false;
 			self->audioFrameQueue.pop_back();
 			frameDiscards++;
@@ -531,7 +538,7 @@ void SDLDriver::SDLAudioCallback(void* userdata, Uint8* stream, int len) {
 			streamPos += consumeBytes;
 			frameFills++;
 		} else {
-			self->logger->debug4("Ran out of audio frames! Filling the rest of the buffer with silence.");
+			YerFace_LogDebug4(self->logger, "Ran out of audio frames! Filling the rest of the buffer with silence.");
 			memset(stream + streamPos, self->audioDevice.obtained.silence, remaining);
 			streamPos += remaining;
 			if(!frameFills && frameDiscards > 0) {
@@ -547,7 +554,7 @@ void SDLDriver::FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf, int
 	if(self->audioFramesMutex == NULL) {
 		return;
 	}
-	self->logger->debug4("FFmpegDriver passed us an audio frame! Frame timestamp is %lf.", timestamp);
+	YerFace_LogDebug4(self->logger, "FFmpegDriver passed us an audio frame! Frame timestamp is %lf.", timestamp);
 	YerFace_MutexLock(self->audioFramesMutex);
 	SDLAudioFrame *audioFrame = self->getNextAvailableAudioFrame(audioBytes);
 	memcpy(audioFrame->buf, buf, audioBytes);
@@ -4,6 +4,7 @@
 #include "Status.hpp"
 #include "FrameServer.hpp"
 #include "FFmpegDriver.hpp"
+#include "MemoryGauge.hpp"
 
 #include <list>
 
@@ -98,6 +99,7 @@ private:
 	SDL_mutex *audioFramesMutex;
 	list<SDLAudioFrame *> audioFrameQueue;
 	list<SDLAudioFrame *> audioFramesAllocated;
+	MemoryGauge *audioFramesGauge;
 
 	SDL_mutex *callbacksMutex;
 	std::vector<function<void(void)>> onBasisFlagCallbacks;
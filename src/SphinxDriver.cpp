@@ -90,6 +90,8 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	if((workingVideoFramesMutex = SDL_CreateMutex()) == NULL) {
 		throw runtime_error("Failed creating mutex!");
 	}
+	audioFramesGauge = new MemoryGauge("SphinxDriver.AudioFrames");
+	recognitionMetrics = new Metrics(config, "SphinxDriver.Recognition");
 	
 	logger->info("Initializing PocketSphinx with Models... <HMM: %s, AllPhone: %s>", hiddenMarkovModel.c_str(), allPhoneLM.c_str());
 	// Configuration for phoneme recognition from: https://cmusphinx.github.io/wiki/phonemerecognition/
@@ -130,6 +132,12 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 	frameStatusChangeCallback.newStatus = FRAME_STATUS_GONE;
 	frameServer->onFrameStatusChangeEvent(frameStatusChangeCallback);
 
+	//If the frame server detects a stall, we want to report on our queues.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	recognizerRunning = true;
 	recognizerDrained = false;
 	WorkerPoolParameters workerPoolParameters;
@@ -173,6 +181,8 @@ SphinxDriver::SphinxDriver(json config, Status *myStatus, FrameServer *myFrameSe
 SphinxDriver::~SphinxDriver() noexcept(false) {
 	logger->debug1("SphinxDriver object destructing...");
 
+	frameServer->removeFrameServerStallEvent((void *)this);
+
 	delete recognitionWorkerPool;
 
 	YerFace_MutexLock(recognitionMutex);
@@ -214,8 +224,11 @@ SphinxDriver::~SphinxDriver() noexcept(false) {
 			logger->crit("About to free an in-use audio frame! Uh oh!");
 		}
 		av_freep(&audioFrame->buf);
+		audioFramesGauge->released(audioFrame->bufferSize);
 		delete audioFrame;
 	}
+	delete audioFramesGauge;
+	delete recognitionMetrics;
 
 	delete logger;
 	delete sphinxLogger;
@@ -281,7 +294,7 @@ bool SphinxDriver::processPhonemeBreakdown(SphinxVideoFrame *videoFrame) {
 		double phonemeStartTime = phonemeBuffer.back().startTime;
 		double phonemeEndTime = phonemeBuffer.back().endTime;
 		TimeIntervalComparison comparison = Utilities::timeIntervalCompare(phonemeStartTime, phonemeEndTime, videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp);
-		logger->debug4("processPhonemeBreakdown() timeIntervalCompare(A: phonemeTime, B: videoFrame)... [A: %lf-%lf (%s)], [B: %lf-%lf], [doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d]", phonemeStartTime, phonemeEndTime, phonemeBuffer.back().pbPhoneme.c_str(), videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp, comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
+		YerFace_LogDebug4(logger, "processPhonemeBreakdown() timeIntervalCompare(A: phonemeTime, B: videoFrame)... [A: %lf-%lf (%s)], [B: %lf-%lf], [doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d]", phonemeStartTime, phonemeEndTime, phonemeBuffer.back().pbPhoneme.c_str(), videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp, comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
 		if(comparison.doesAEndBeforeB) {
 			phonemeBuffer.pop_back();
 			continue;
@@ -379,7 +392,7 @@ void SphinxDriver::processLipFlappingAudio(SphinxVideoFrame *videoFrame) {
 	YerFace_MutexLock(recognitionMutex);
 	while(recognitionResults.size()) {
 		TimeIntervalComparison comparison = Utilities::timeIntervalCompare(recognitionResults.back().startTimestamp, recognitionResults.back().endTimestamp, videoFrame->timestamps.startTimestamp, videoFrame->timestamps.estimatedEndTimestamp);
-		logger->debug4("processLipFlappingAudio() timeIntervalCompare(A: recognitionResult, B: videoFrame)... doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d", comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
+		YerFace_LogDebug4(logger, "processLipFlappingAudio() timeIntervalCompare(A: recognitionResult, B: videoFrame)... doesAEndBeforeB: %d, doesAOccurBeforeB: %d, doesAOccurDuringB: %d, doesAOccurAfterB: %d, doesAStartAfterB: %d", comparison.doesAEndBeforeB, comparison.doesAOccurBeforeB, comparison.doesAOccurDuringB, comparison.doesAOccurAfterB, comparison.doesAStartAfterB);
 		if(comparison.doesAEndBeforeB) {
 			recognitionResults.pop_back();
 			continue;
@@ -429,10 +442,12 @@ SphinxAudioFrame *SphinxDriver::getNextAvailableAudioFrame(int desiredBufferSize
 			if(audioFrame->bufferSize < desiredBufferSize) {
 				//Not using realloc because it does not support guaranteed buffer alignment.
 				av_freep(&audioFrame->buf);
+				audioFramesGauge->released(audioFrame->bufferSize, 0);
 				if((audioFrame->buf = (uint8_t *)av_malloc(desiredBufferSize)) == NULL) {
 					throw runtime_error("unable to allocate memory for audio frame");
 				}
 				audioFrame->bufferSize = desiredBufferSize;
+				audioFramesGauge->allocated(audioFrame->bufferSize, 0);
 			}
 			audioFrame->pos = 0;
 			audioFrame->inUse = true;
@@ -448,6 +463,7 @@ SphinxAudioFrame *SphinxDriver::getNextAvailableAudioFrame(int desiredBufferSize
 	audioFrame->pos = 0;
 	audioFrame->inUse = true;
 	audioFramesAllocated.push_front(audioFrame);
+	audioFramesGauge->allocated(audioFrame->bufferSize);
 	YerFace_MutexUnlock(recognitionMutex);
 	return audioFrame;
 }
@@ -491,6 +507,20 @@ void SphinxDriver::FFmpegDriverAudioIsDrainedCallback(void *userdata) {
 	}
 }
 
+void SphinxDriver::handleFrameServerStallEvent(void *userdata) {
+	SphinxDriver *self = (SphinxDriver *)userdata;
+	YerFace_MutexLock(self->recognitionMutex);
+	size_t audioDepth = self->audioFrameQueue.size();
+	size_t recognitionResultsDepth = self->recognitionResults.size();
+	size_t phonemeDepth = self->phonemeBuffer.size();
+	bool myRecognizerDrained = self->recognizerDrained;
+	YerFace_MutexUnlock(self->recognitionMutex);
+	YerFace_MutexLock(self->workingVideoFramesMutex);
+	size_t videoDepth = self->workingVideoFrames.size();
+	YerFace_MutexUnlock(self->workingVideoFramesMutex);
+	self->logger->warning("... Queue depths: <Audio Frames: %lu, Recognition Results: %lu, Phonemes: %lu, Working Video Frames: %lu> Recognizer Drained: %s", audioDepth, recognitionResultsDepth, phonemeDepth, videoDepth, myRecognizerDrained ? "TRUE" : "FALSE");
+}
+
 void SphinxDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps) {
 	SphinxDriver *self = (SphinxDriver *)userdata;
 	FrameNumber frameNumber = frameTimestamps.frameNumber;
@@ -511,7 +541,7 @@ void SphinxDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			break;
 		case FRAME_STATUS_MAPPING:
 			YerFace_MutexLock(self->workingVideoFramesMutex);
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on Lip Flapping Worker. Queue depth is now %lu", frameNumber, self->workingVideoFrames.size());
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on Lip Flapping Worker. Queue depth is now %lu", frameNumber, self->workingVideoFrames.size());
 			self->workingVideoFrames[frameNumber]->isLipFlappingReady = true;
 			YerFace_MutexUnlock(self->workingVideoFramesMutex);
 			if(self->lipFlappingWorkerPool != NULL) {
@@ -520,7 +550,7 @@ void SphinxDriver::handleFrameStatusChange(void *userdata, WorkingFrameStatus ne
 			break;
 		case FRAME_STATUS_LATE_PROCESSING:
 			YerFace_MutexLock(self->workingVideoFramesMutex);
-			self->logger->debug4("handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on Phoneme Breakdown Worker. Queue depth is now %lu", frameNumber, self->workingVideoFrames.size());
+			YerFace_LogDebug4(self->logger, "handleFrameStatusChange() Frame #" YERFACE_FRAMENUMBER_FORMAT " waiting on Phoneme Breakdown Worker. Queue depth is now %lu", frameNumber, self->workingVideoFrames.size());
 			self->workingVideoFrames[frameNumber]->isPhonemeBreakdownReady = true;
 			YerFace_MutexUnlock(self->workingVideoFramesMutex);
 			if(self->phonemeBreakdownWorkerPool != NULL) {
@@ -550,9 +580,11 @@ bool SphinxDriver::recognitionWorkerHandler(WorkerPoolWorker *worker) {
 
 	YerFace_MutexLock(self->recognitionMutex);
 	if(self->audioFrameQueue.size() > 0) {
+		MetricsTick tick = self->recognitionMetrics->startClock();
 		if(ps_process_raw(self->pocketSphinx, (int16 const *)self->audioFrameQueue.back()->buf, self->audioFrameQueue.back()->audioSamples, 0, 0) < 0) {
 			throw runtime_error("Failed processing audio samples in PocketSphinx");
 		}
+		self->recognitionMetrics->endClock(tick);
 		self->inSpeech = ps_get_in_speech(self->pocketSphinx);
 		SphinxRecognizerResult result;
 		result.maxAmplitude = 0.0;
@@ -654,7 +686,7 @@ bool SphinxDriver::lipFlappingWorkerHandler(WorkerPoolWorker *worker) {
 	}
 	if(videoFrame != NULL) {
 		if(!videoFrame->isLipFlappingReady) {
-			self->logger->debug4("Lip Flapping BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
+			YerFace_LogDebug4(self->logger, "Lip Flapping BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 			myFrameNumber = -1;
 			videoFrame = NULL;
 		}
@@ -663,7 +695,7 @@ bool SphinxDriver::lipFlappingWorkerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(videoFrame != NULL) {
-		self->logger->debug4("Lip Flapping Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
+		YerFace_LogDebug4(self->logger, "Lip Flapping Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 
 		if(myFrameNumber <= lastFrameNumber) {
 			throw logic_error("SphinxDriver Lip Flapping Worker handling frames out of order!");
@@ -709,7 +741,7 @@ bool SphinxDriver::phonemeBreakdownWorkerHandler(WorkerPoolWorker *worker) {
 	}
 	if(videoFrame != NULL) {
 		if(!videoFrame->isPhonemeBreakdownReady) {
-			self->logger->debug4("Phoneme Breakdown BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
+			YerFace_LogDebug4(self->logger, "Phoneme Breakdown BLOCKED on frame " YERFACE_FRAMENUMBER_FORMAT " because it is not ready!", myFrameNumber);
 			myFrameNumber = -1;
 			videoFrame = NULL;
 		}
@@ -718,7 +750,7 @@ bool SphinxDriver::phonemeBreakdownWorkerHandler(WorkerPoolWorker *worker) {
 
 	//// DO THE WORK ////
 	if(videoFrame != NULL) {
-		self->logger->debug4("Phoneme Breakdown Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
+		YerFace_LogDebug4(self->logger, "Phoneme Breakdown Worker Thread handling frame #" YERFACE_FRAMENUMBER_FORMAT, myFrameNumber);
 
 		if(myFrameNumber <= lastFrameNumber) {
 			throw logic_error("SphinxDriver Phoneme Breakdown Worker handling frames out of order!");
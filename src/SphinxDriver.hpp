@@ -9,6 +9,7 @@
 #include "Status.hpp"
 #include "WorkerPool.hpp"
 #include "PreviewHUD.hpp"
+#include "MemoryGauge.hpp"
 
 namespace PocketSphinx {
 extern "C" {
@@ -81,6 +82,7 @@ private:
 	static void FFmpegDriverAudioFrameCallback(void *userdata, uint8_t *buf, int audioSamples, int audioBytes, double timestamp);
 	static void FFmpegDriverAudioIsDrainedCallback(void *userdata);
 	static void handleFrameStatusChange(void *userdata, WorkingFrameStatus newStatus, FrameTimestamps frameTimestamps);
+	static void handleFrameServerStallEvent(void *userdata);
 	static bool recognitionWorkerHandler(WorkerPoolWorker *worker);
 	static void recognitionWorkerDeinitializer(WorkerPoolWorker *worker, void *usrPtr);
 	static bool lipFlappingWorkerHandler(WorkerPoolWorker *worker);
@@ -106,10 +108,12 @@ private:
 	PocketSphinx::cmd_ln_t *pocketSphinxConfig;
 
 	WorkerPool *recognitionWorkerPool;
+	Metrics *recognitionMetrics;
 	SDL_mutex *recognitionMutex;
 	bool recognizerRunning, recognizerDrained;
 	list<SphinxAudioFrame *> audioFrameQueue;
 	list<SphinxAudioFrame *> audioFramesAllocated;
+	MemoryGauge *audioFramesGauge;
 	bool utteranceRestarted, inSpeech;
 	int utteranceIndex;
 	double lastUtteranceEndedTimestamp;
@@ -1,6 +1,7 @@
 
 #include "Utilities.hpp"
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
 #include <sys/stat.h>
 #include <regex>
@@ -32,6 +33,14 @@ Rect2d Utilities::insetBox(Rect2d originalBox, double scale) {
 		newBoxHeight);
 }
 
+double Utilities::boxOverlap(Rect2d a, Rect2d b) {
+	double unionArea = (a | b).area();
+	if(unionArea <= 0.0) {
+		return 0.0;
+	}
+	return (a & b).area() / unionArea;
+}
+
 Point2d Utilities::centerRect(Rect2d rect) {
 	Point2d center = Point2d(rect.width / 2.0, rect.height / 2.0);
 	return rect.tl() + center;
@@ -110,17 +119,17 @@ double Utilities::radiansToDegrees(double radians, bool normalize) {
 	return degrees;
 }
 
-Vec3d Utilities::rotationMatrixToEulerAngles(Mat &R, bool returnDegrees, bool degreesReflectAroundZero) {
-	double sy = std::sqrt(R.at<double>(0,0) * R.at<double>(0,0) + R.at<double>(1,0) * R.at<double>(1,0));
+Vec3d Utilities::rotationMatrixToEulerAngles(const Matx33d &R, bool returnDegrees, bool degreesReflectAroundZero) {
+	double sy = std::sqrt(R(0,0) * R(0,0) + R(1,0) * R(1,0));
 
 	double x, y, z;
 	if(sy > 0.0) {
-		x = atan2(R.at<double>(2,1) , R.at<double>(2,2));
-		y = atan2(-R.at<double>(2,0), sy);
-		z = atan2(R.at<double>(1,0), R.at<double>(0,0));
+		x = atan2(R(2,1) , R(2,2));
+		y = atan2(-R(2,0), sy);
+		z = atan2(R(1,0), R(0,0));
 	} else {
-		x = atan2(-R.at<double>(1,2), R.at<double>(1,1));
-		y = atan2(-R.at<double>(2,0), sy);
+		x = atan2(-R(1,2), R(1,1));
+		y = atan2(-R(2,0), sy);
 		z = 0;
 	}
 	if(returnDegrees) {
@@ -137,7 +146,7 @@ Vec3d Utilities::rotationMatrixToEulerAngles(Mat &R, bool returnDegrees, bool de
 	return Vec3d(x, y, z);
 }
 
-Mat Utilities::eulerAnglesToRotationMatrix(Vec3d &R, bool expectDegrees) {
+Matx33d Utilities::eulerAnglesToRotationMatrix(Vec3d &R, bool expectDegrees) {
 	Vec3d rot;
 	if(expectDegrees) {
 		rot = Vec3d(Utilities::degreesToRadians(R[0]), Utilities::degreesToRadians(R[1]), Utilities::degreesToRadians(R[2]));
@@ -145,41 +154,71 @@ Mat Utilities::eulerAnglesToRotationMatrix(Vec3d &R, bool expectDegrees) {
 		rot = Vec3d(R);
 	}
 
-	Mat matrixX = (Mat_<double>(3,3) <<
+	Matx33d matrixX = Matx33d(
 		1.0, 0.0,          0.0,
 		0.0, cos(rot[0]), -sin(rot[0]),
 		0.0, sin(rot[0]),  cos(rot[0]));
 
-	Mat matrixY = (Mat_<double>(3,3) <<
+	Matx33d matrixY = Matx33d(
 		 cos(rot[1]), 0.0, sin(rot[1]),
 		 0.0,         1.0, 0.0,
 		-sin(rot[1]), 0.0, cos(rot[1]));
 
-	Mat matrixZ = (Mat_<double>(3,3) <<
+	Matx33d matrixZ = Matx33d(
 		cos(rot[2]), -sin(rot[2]), 0.0,
 		sin(rot[2]),  cos(rot[2]), 0.0,
 		0.0,          0.0,         1.0);
 
-	Mat matrix = matrixZ * matrixY * matrixX;
-	return matrix;
+	return matrixZ * matrixY * matrixX;
 }
 
-double Utilities::degreesDifferenceBetweenTwoRotationMatrices(Mat a, Mat b) {
-	Mat aTransposed = a.t();
-	Mat ab = aTransposed * b;
-	Scalar abTraceScalar = cv::trace(ab);
-	double abTrace = abTraceScalar[0];
-	while(abTrace > 1.0) {
-		abTrace = abTrace - 2.0;
+Vec4d Utilities::rotationVectorToQuaternion(Vec3d rotationVector) {
+	double angle = cv::norm(rotationVector);
+	if(angle <= 0.0) {
+		return Vec4d(1.0, 0.0, 0.0, 0.0);
 	}
-	while(abTrace < -1.0) {
-		abTrace = abTrace + 2.0;
+	double scale = std::sin(angle / 2.0) / angle;
+	return Vec4d(std::cos(angle / 2.0), rotationVector[0] * scale, rotationVector[1] * scale, rotationVector[2] * scale);
+}
+
+Matx33d Utilities::quaternionToRotationMatrix(Vec4d q) {
+	double w = q[0], x = q[1], y = q[2], z = q[3];
+	return Matx33d(
+		1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - w * z),       2.0 * (x * z + w * y),
+		2.0 * (x * y + w * z),       1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - w * x),
+		2.0 * (x * z - w * y),       2.0 * (y * z + w * x),       1.0 - 2.0 * (x * x + y * y));
+}
+
+Vec4d Utilities::quaternionNlerp(Vec4d a, Vec4d b, double progress) {
+	//q and -q are the same rotation. Take the short way around.
+	if(a.dot(b) < 0.0) {
+		b = -b;
 	}
-	return Utilities::radiansToDegrees(std::acos(abTrace) / 2.0);
+	return cv::normalize(a * (1.0 - progress) + b * progress);
 }
 
-Mat Utilities::generateFakeCameraMatrix(double focalLength, Point2d principalPoint) {
-	return (Mat_<double>(3,3) <<
+Vec4d Utilities::quaternionSlerp(Vec4d a, Vec4d b, double progress) {
+	double dot = a.dot(b);
+	if(dot < 0.0) {
+		b = -b;
+		dot = -dot;
+	}
+	//Nearly parallel quaternions make the slerp denominator unstable, and nlerp is indistinguishable there anyway.
+	if(dot > 0.9995) {
+		return quaternionNlerp(a, b, progress);
+	}
+	double theta = std::acos(dot);
+	double sinTheta = std::sin(theta);
+	return a * (std::sin((1.0 - progress) * theta) / sinTheta) + b * (std::sin(progress * theta) / sinTheta);
+}
+
+double Utilities::degreesDifferenceBetweenTwoQuaternions(Vec4d a, Vec4d b) {
+	double dot = std::min(1.0, std::fabs(a.dot(b)));
+	return Utilities::radiansToDegrees(2.0 * std::acos(dot));
+}
+
+Matx33d Utilities::generateFakeCameraMatrix(double focalLength, Point2d principalPoint) {
+	return Matx33d(
 		focalLength, 0.0,         principalPoint.x,
 		0.0,         focalLength, principalPoint.y,
 		0.0,         0.0,         1.0);
@@ -188,19 +227,13 @@ Mat Utilities::generateFakeCameraMatrix(double focalLength, Point2d principalPoi
 bool Utilities::rayPlaneIntersection(Point3d &intersection, Point3d rayOrigin, Vec3d rayVector, Point3d planePoint, Vec3d planeNormal) {
 	Vec3d rayVectorNormalized = cv::normalize(rayVector);
 
-	Mat rayOriginMat, rayVectorMat, planeNormalMat, planePointMat;
-	rayOriginMat = (Mat_<double>(3, 1) << rayOrigin.x, rayOrigin.y, rayOrigin.z);
-	rayVectorMat = (Mat_<double>(3, 1) << rayVectorNormalized[0], rayVectorNormalized[1], rayVectorNormalized[2]);
-	planePointMat = (Mat_<double>(3, 1) << planePoint.x, planePoint.y, planePoint.z);
-	planeNormalMat = (Mat_<double>(3, 1) << planeNormal[0], planeNormal[1], planeNormal[2]);
-
-
-	if(planeNormalMat.dot(rayVectorMat) == 0) {
+	double denominator = planeNormal.dot(rayVectorNormalized);
+	if(denominator == 0) {
 		return false;
 	}
 
-	double d = planeNormalMat.dot(planePointMat);
-	double t = (d - planeNormalMat.dot(rayOriginMat)) / planeNormalMat.dot(rayVectorMat);
+	double d = planeNormal.dot(Vec3d(planePoint));
+	double t = (d - planeNormal.dot(Vec3d(rayOrigin))) / denominator;
 
 	intersection.x = rayOrigin.x + (rayVectorNormalized[0] * t);
 	intersection.y = rayOrigin.y + (rayVectorNormalized[1] * t);
@@ -301,7 +334,7 @@ bool Utilities::fileExists(string filePath) {
 string Utilities::fileSearchInCommonLocations(string filePath) {
 	if(sdlDataPath == NULL) {
 		sdlDataPath = SDL_GetBasePath();
-		logger->debug3("SDL Reports Data Path: %s", sdlDataPath);
+		YerFace_LogDebug3(logger, "SDL Reports Data Path: %s", sdlDataPath);
 	}
 
 	vector<string> searchBases;
@@ -335,16 +368,16 @@ string Utilities::fileSearchInCommonLocations(string filePath) {
 		""
 	};
 	for(string searchBase : searchBases) {
-		logger->debug3("=== Searching BASE: %s", searchBase.c_str());
+		YerFace_LogDebug3(logger, "=== Searching BASE: %s", searchBase.c_str());
 		for(string searchSecondComponent : searchSecondComponents) {
-			logger->debug3("== Searching 2nd: %s", searchSecondComponent.c_str());
+			YerFace_LogDebug3(logger, "== Searching 2nd: %s", searchSecondComponent.c_str());
 			for(string searchThirdComponent : searchThirdComponents) {
-				logger->debug3("= Searching 3rd: %s", searchThirdComponent.c_str());
+				YerFace_LogDebug3(logger, "= Searching 3rd: %s", searchThirdComponent.c_str());
 				string testPath = searchBase + searchSecondComponent + searchThirdComponent + filePath;
 				#ifdef WIN32
 				testPath = std::regex_replace(testPath, std::regex("/"), "\\");
 				#endif
-				logger->debug4("TEST PATH: %s", testPath.c_str());
+				YerFace_LogDebug4(logger, "TEST PATH: %s", testPath.c_str());
 				if(fileExists(testPath)) {
 					return testPath;
 				}
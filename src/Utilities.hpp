@@ -150,6 +150,7 @@ public:
 	static cv::Rect2d scaleRect(cv::Rect2d rect, double scale);
 	static cv::Rect2d insetBox(cv::Rect2d originalBox, double scale);
 	static cv::Point2d centerRect(cv::Rect2d rect);
+	static double boxOverlap(cv::Rect2d a, cv::Rect2d b); //Intersection over union.
 	static cv::Point2d averagePoint(std::vector<cv::Point2d> points);
 	static double morph(double a, double b, double progress);
 	static double lineDistance(cv::Point2d a, cv::Point2d b);
@@ -157,10 +158,14 @@ public:
 	static TimeIntervalComparison timeIntervalCompare(double startTimeA, double endTimeA, double startTimeB, double endTimeB);
 	static double degreesToRadians(double degrees);
 	static double radiansToDegrees(double radians, bool normalize = true);
-	static cv::Vec3d rotationMatrixToEulerAngles(cv::Mat &R, bool returnDegrees = true, bool degreesReflectAroundZero = true);
-	static cv::Mat eulerAnglesToRotationMatrix(cv::Vec3d &R, bool expectDegrees = true);
-	static double degreesDifferenceBetweenTwoRotationMatrices(cv::Mat a, cv::Mat b);
-	static cv::Mat generateFakeCameraMatrix(double focalLength = 1.0, cv::Point2d principalPoint = cv::Point2d(0, 0));
+	static cv::Vec3d rotationMatrixToEulerAngles(const cv::Matx33d &R, bool returnDegrees = true, bool degreesReflectAroundZero = true);
+	static cv::Matx33d eulerAnglesToRotationMatrix(cv::Vec3d &R, bool expectDegrees = true);
+	static cv::Vec4d rotationVectorToQuaternion(cv::Vec3d rotationVector); //Quaternions are unit length, stored as (w, x, y, z).
+	static cv::Matx33d quaternionToRotationMatrix(cv::Vec4d q);
+	static cv::Vec4d quaternionNlerp(cv::Vec4d a, cv::Vec4d b, double progress);
+	static cv::Vec4d quaternionSlerp(cv::Vec4d a, cv::Vec4d b, double progress);
+	static double degreesDifferenceBetweenTwoQuaternions(cv::Vec4d a, cv::Vec4d b);
+	static cv::Matx33d generateFakeCameraMatrix(double focalLength = 1.0, cv::Point2d principalPoint = cv::Point2d(0, 0));
 	static bool rayPlaneIntersection(cv::Point3d &intersection, cv::Point3d rayOrigin, cv::Vec3d rayVector, cv::Point3d planePoint, cv::Vec3d planeNormal);
 	static void drawRotatedRectOutline(cv::Mat frame, cv::RotatedRect rrect, cv::Scalar color = cv::Scalar(0, 0, 255), int thickness = 1);
 	static void drawX(cv::Mat frame, cv::Point2d markerPoint, cv::Scalar color = cv::Scalar(0, 0, 255), int lineLength = 5, int thickness = 1);
@@ -45,6 +45,12 @@ WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer
 	frameServerDrainedCallback.callback = handleFrameServerDrainedEvent;
 	frameServer->onFrameServerDrainedEvent(frameServerDrainedCallback);
 
+	//We report on our workers if the frame server detects a stall.
+	FrameServerStallEventCallback frameServerStallCallback;
+	frameServerStallCallback.userdata = (void *)this;
+	frameServerStallCallback.callback = handleFrameServerStallEvent;
+	frameServer->onFrameServerStallEvent(frameServerStallCallback);
+
 	//Start worker threads.
 	if(parameters.numWorkers == 0) {
 		int numCPUs = SDL_GetCPUCount();
@@ -61,6 +67,8 @@ WorkerPool::WorkerPool(json config, Status *myStatus, FrameServer *myFrameServer
 		worker->num = i;
 		worker->ptr = parameters.usrPtr;
 		worker->pool = this;
+		worker->activity = WORKER_ACTIVITY_STARTING;
+		worker->activityChangedTime = (double)getTickCount() / (double)getTickFrequency();
 		if((worker->thread = SDL_CreateThread(outerWorkerLoop, parameters.name.c_str(), (void *)worker)) == NULL) {
 			throw runtime_error("Failed starting thread!");
 		}
@@ -83,6 +91,13 @@ WorkerPool::~WorkerPool() noexcept(false) {
 
 	for(auto worker : workers) {
 		SDL_WaitThread(worker->thread, NULL);
+	}
+
+	//Stall reports walk our worker list, so stop listening before it goes away.
+	frameServer->removeFrameServerDrainedEvent((void *)this);
+	frameServer->removeFrameServerStallEvent((void *)this);
+
+	for(auto worker : workers) {
 		delete worker;
 	}
 
@@ -97,6 +112,11 @@ void WorkerPool::sendWorkerSignal(void) {
 	YerFace_MutexUnlock(myMutex);
 }
 
+int WorkerPool::getNumWorkers(void) {
+	//Fixed before any worker starts, so no lock is needed.
+	return parameters.numWorkers;
+}
+
 void WorkerPool::stopWorkerNow(void) {
 	YerFace_MutexLock(myMutex);
 	running = false;
@@ -117,6 +137,41 @@ void WorkerPool::handleFrameServerDrainedEvent(void *userdata) {
 	YerFace_MutexUnlock(self->myMutex);
 }
 
+void WorkerPool::handleFrameServerStallEvent(void *userdata) {
+	WorkerPool *self = (WorkerPool *)userdata;
+	double now = (double)getTickCount() / (double)getTickFrequency();
+	YerFace_MutexLock(self->myMutex);
+	for(auto worker : self->workers) {
+		self->logger->warning("... Thread #%d is %s (for %.02lf seconds)", worker->num, getWorkerActivityString(worker->activity).c_str(), now - worker->activityChangedTime);
+	}
+	YerFace_MutexUnlock(self->myMutex);
+}
+
+string WorkerPool::getWorkerActivityString(WorkerPoolWorkerActivity activity) {
+	switch(activity) {
+		case WORKER_ACTIVITY_STARTING:
+			return "STARTING";
+		case WORKER_ACTIVITY_IDLE:
+			return "IDLE";
+		case WORKER_ACTIVITY_PAUSED:
+			return "PAUSED";
+		case WORKER_ACTIVITY_WORKING:
+			return "WORKING";
+		case WORKER_ACTIVITY_STOPPING:
+			return "STOPPING";
+	}
+	return "?????";
+}
+
+void WorkerPool::setWorkerActivity(WorkerPoolWorker *worker, WorkerPoolWorkerActivity activity) {
+	YerFace_MutexLock(myMutex);
+	if(worker->activity != activity) {
+		worker->activity = activity;
+		worker->activityChangedTime = (double)getTickCount() / (double)getTickFrequency();
+	}
+	YerFace_MutexUnlock(myMutex);
+}
+
 int WorkerPool::outerWorkerLoop(void *ptr) {
 	WorkerPoolWorker *worker = (WorkerPoolWorker *)ptr;
 	WorkerPool *self = worker->pool;
@@ -132,18 +187,21 @@ int WorkerPool::outerWorkerLoop(void *ptr) {
 			// self->logger->debug4("Thread #%d Top of Loop", worker->num);
 
 			if(self->status->getIsPaused() && self->status->getIsRunning()) {
+				self->setWorkerActivity(worker, WORKER_ACTIVITY_PAUSED);
 				YerFace_MutexUnlock(self->myMutex);
 				SDL_Delay(100);
 				YerFace_MutexLock(self->myMutex);
 				continue;
 			}
 
+			self->setWorkerActivity(worker, WORKER_ACTIVITY_WORKING);
 			YerFace_MutexUnlock(self->myMutex);
 			bool didWork = self->parameters.handler(worker);
 			YerFace_MutexLock(self->myMutex);
 
 			//If there is no work available, go to sleep and wait.
 			if(!didWork) {
+				self->setWorkerActivity(worker, WORKER_ACTIVITY_IDLE);
 				// self->logger->verbose("Thread #%d entering CondWait...", worker->num);
 				int result = SDL_CondWaitTimeout(self->myCond, self->myMutex, 1000);
 				if(result < 0) {
@@ -160,6 +218,7 @@ int WorkerPool::outerWorkerLoop(void *ptr) {
 				self->running = false;
 			}
 		}
+		self->setWorkerActivity(worker, WORKER_ACTIVITY_STOPPING);
 		YerFace_MutexUnlock(self->myMutex);
 
 		if(self->parameters.deinitializer != NULL) {
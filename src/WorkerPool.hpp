@@ -13,12 +13,24 @@ namespace YerFace {
 
 class WorkerPool;
 
+enum WorkerPoolWorkerActivity: unsigned int {
+	WORKER_ACTIVITY_STARTING = 0, //Worker thread has been created, but has not finished its initializer.
+	WORKER_ACTIVITY_IDLE = 1, //Worker is waiting for a signal that there is work to do.
+	WORKER_ACTIVITY_PAUSED = 2, //Worker is sleeping because the application is paused.
+	WORKER_ACTIVITY_WORKING = 3, //Worker is executing its handler.
+	WORKER_ACTIVITY_STOPPING = 4, //Worker has left its loop and is running its deinitializer (or is already done).
+};
+
 class WorkerPoolWorker {
 public:
 	int num;
 	SDL_Thread *thread;
 	void *ptr;
 	WorkerPool *pool;
+
+	//Activity is protected by the pool's mutex, and is only used for diagnostics.
+	WorkerPoolWorkerActivity activity;
+	double activityChangedTime;
 };
 
 typedef function<void(WorkerPoolWorker *worker, void *ptr)> WorkerPoolWorkerInitializer;
@@ -44,8 +56,12 @@ public:
 	~WorkerPool() noexcept(false);
 	void sendWorkerSignal(void);
 	void stopWorkerNow(void);
+	int getNumWorkers(void);
 private:
 	static void handleFrameServerDrainedEvent(void *userdata);
+	static void handleFrameServerStallEvent(void *userdata);
+	static string getWorkerActivityString(WorkerPoolWorkerActivity activity);
+	void setWorkerActivity(WorkerPoolWorker *worker, WorkerPoolWorkerActivity activity);
 	static int outerWorkerLoop(void *ptr);
 
 	Status *status;
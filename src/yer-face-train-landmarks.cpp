@@ -0,0 +1,214 @@
+#include "FaceLandmarks.hpp"
+
+#include "opencv2/core/utility.hpp"
+
+#include "dlib/image_processing.h"
+#include "dlib/data_io.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace cv;
+using namespace YerFace;
+
+// Trains a dlib shape predictor on just the landmarks YerFace actually reads.
+//  Prediction time scales with the number of landmarks and the depth of the trees, so a smaller, shallower model is a direct speedup.
+//  Training data is dlib's imglab XML format with the iBUG 68 point annotations, e.g. the iBUG 300-W dataset distributed by dlib.
+
+int trainLandmarks(int argc, char *argv[]);
+std::vector<int> parseLandmarkIndexes(string landmarksString);
+dlib::full_object_detection reduceLandmarks(const dlib::full_object_detection &detection, const std::vector<int> &landmarkIndexes);
+double getInterOcularDistance(const dlib::full_object_detection &detection, const std::vector<int> &landmarkIndexes);
+
+int main(int argc, char *argv[]) {
+	try {
+		return trainLandmarks(argc, argv);
+	} catch(exception &e) {
+		fprintf(stderr, "Uncaught exception: %s\n", e.what());
+	}
+	return 1;
+}
+
+int trainLandmarks(int argc, char *argv[]) {
+	//Command line options. NOTE: Remember to update the documentation when making changes here!
+	CommandLineParser parser(argc, argv,
+		"{help h usage ?||Display command line usage documentation.}"
+		"{inTrainingXML||Required dlib imglab XML file with iBUG 68 point annotations to train on.}"
+		"{inTestingXML||Optional dlib imglab XML file with iBUG 68 point annotations to measure the trained model against.}"
+		"{outModel||Required output file for the trained shape predictor. (Point FaceTracker's dlibFaceLandmarks setting at this.)}"
+		"{landmarks||Comma separated iBUG landmark indexes to train on. If not specified, only the landmarks YerFace requires.}"
+		"{treeDepth|3|Depth of each regression tree. (The stock model uses 5.) Each extra level doubles the size of the trees.}"
+		"{cascadeDepth|10|Number of cascades.}"
+		"{treesPerCascade|500|Number of regression trees in each cascade.}"
+		"{oversampling|20|How many random deformations of each training face to generate.}"
+		"{nu|0.1|Regularization. Smaller values fit the training data less closely.}"
+		"{featurePoolSize|400|Number of pixels sampled from each face to build features.}"
+		"{numThreads|0|Number of training threads. If zero, use one per CPU.}"
+		);
+	parser.about("YerFace! Reduced landmark shape predictor trainer. [" YERFACE_VERSION "]");
+	if(argc <= 1) {
+		parser.printMessage();
+		return 0;
+	}
+	if(parser.has("help") && parser.get<bool>("help")) {
+		parser.printMessage();
+		return 1;
+	}
+	string inTrainingXML = parser.get<string>("inTrainingXML");
+	if(inTrainingXML.length() == 0) {
+		throw invalid_argument("--inTrainingXML is a required argument, but is blank or not specified!");
+	}
+	string inTestingXML = parser.get<string>("inTestingXML");
+	string outModel = parser.get<string>("outModel");
+	if(outModel.length() == 0) {
+		throw invalid_argument("--outModel is a required argument, but is blank or not specified!");
+	}
+	std::vector<int> landmarkIndexes = parseLandmarkIndexes(parser.get<string>("landmarks"));
+	int treeDepth = parser.get<int>("treeDepth");
+	if(treeDepth < 1) {
+		throw invalid_argument("--treeDepth cannot be less than one.");
+	}
+	int cascadeDepth = parser.get<int>("cascadeDepth");
+	if(cascadeDepth < 1) {
+		throw invalid_argument("--cascadeDepth cannot be less than one.");
+	}
+	int treesPerCascade = parser.get<int>("treesPerCascade");
+	if(treesPerCascade < 1) {
+		throw invalid_argument("--treesPerCascade cannot be less than one.");
+	}
+	int oversampling = parser.get<int>("oversampling");
+	if(oversampling < 1) {
+		throw invalid_argument("--oversampling cannot be less than one.");
+	}
+	double nu = parser.get<double>("nu");
+	if(nu <= 0.0 || nu > 1.0) {
+		throw invalid_argument("--nu must be greater than zero and no greater than one.");
+	}
+	int featurePoolSize = parser.get<int>("featurePoolSize");
+	if(featurePoolSize < 2) {
+		throw invalid_argument("--featurePoolSize cannot be less than two.");
+	}
+	int numThreads = parser.get<int>("numThreads");
+	if(numThreads < 0) {
+		throw invalid_argument("--numThreads cannot be less than zero.");
+	}
+	if(numThreads == 0) {
+		numThreads = getNumberOfCPUs();
+	}
+	if(!parser.check()) {
+		parser.printErrors();
+		return 1;
+	}
+
+	dlib::array<dlib::array2d<unsigned char>> trainingImages;
+	std::vector<std::vector<dlib::full_object_detection>> trainingFaces;
+	std::vector<string> partNames = dlib::load_image_dataset(trainingImages, trainingFaces, inTrainingXML);
+	if(partNames.size() != YERFACE_NUM_FACE_LANDMARKS) {
+		throw runtime_error("Training data must be annotated with the iBUG 68 point scheme.");
+	}
+	for(auto &imageFaces : trainingFaces) {
+		for(auto &face : imageFaces) {
+			face = reduceLandmarks(face, landmarkIndexes);
+		}
+	}
+	fprintf(stderr, "Training on %lu images with %lu landmarks per face...\n", (unsigned long)trainingImages.size(), (unsigned long)landmarkIndexes.size());
+
+	dlib::shape_predictor_trainer trainer;
+	trainer.set_tree_depth(treeDepth);
+	trainer.set_cascade_depth(cascadeDepth);
+	trainer.set_num_trees_per_cascade_level(treesPerCascade);
+	trainer.set_oversampling_amount(oversampling);
+	trainer.set_nu(nu);
+	trainer.set_feature_pool_size(featurePoolSize);
+	trainer.set_num_threads(numThreads);
+	trainer.be_verbose();
+	dlib::shape_predictor shapePredictor = trainer.train(trainingImages, trainingFaces);
+	dlib::serialize(outModel) << shapePredictor;
+	fprintf(stderr, "Wrote %s\n", outModel.c_str());
+
+	//Errors are reported as a fraction of the distance between the outer eye corners, like the iBUG 300-W benchmarks.
+	std::vector<std::vector<double>> trainingScales;
+	for(auto &imageFaces : trainingFaces) {
+		std::vector<double> imageScales;
+		for(auto &face : imageFaces) {
+			imageScales.push_back(getInterOcularDistance(face, landmarkIndexes));
+		}
+		trainingScales.push_back(imageScales);
+	}
+	fprintf(stderr, "Mean training error: %lf\n", dlib::test_shape_predictor(shapePredictor, trainingImages, trainingFaces, trainingScales));
+	if(inTestingXML.length() > 0) {
+		dlib::array<dlib::array2d<unsigned char>> testingImages;
+		std::vector<std::vector<dlib::full_object_detection>> testingFaces;
+		partNames = dlib::load_image_dataset(testingImages, testingFaces, inTestingXML);
+		if(partNames.size() != YERFACE_NUM_FACE_LANDMARKS) {
+			throw runtime_error("Testing data must be annotated with the iBUG 68 point scheme.");
+		}
+		std::vector<std::vector<double>> testingScales;
+		for(auto &imageFaces : testingFaces) {
+			std::vector<double> imageScales;
+			for(auto &face : imageFaces) {
+				face = reduceLandmarks(face, landmarkIndexes);
+				imageScales.push_back(getInterOcularDistance(face, landmarkIndexes));
+			}
+			testingScales.push_back(imageScales);
+		}
+		fprintf(stderr, "Mean testing error: %lf\n", dlib::test_shape_predictor(shapePredictor, testingImages, testingFaces, testingScales));
+	}
+
+	//FaceTracker needs to know which landmark each of the model's parts is.
+	stringstream indexesStream;
+	for(size_t i = 0; i < landmarkIndexes.size(); i++) {
+		indexesStream << (i > 0 ? ", " : "") << landmarkIndexes[i];
+	}
+	fprintf(stdout, "\"dlibFaceLandmarksIndexes\": [%s]\n", indexesStream.str().c_str());
+	return 0;
+}
+
+std::vector<int> parseLandmarkIndexes(string landmarksString) {
+	std::vector<int> landmarkIndexes;
+	if(landmarksString.length() == 0) {
+		for(int landmarkIndex : requiredFaceLandmarkIndexes) {
+			landmarkIndexes.push_back(landmarkIndex);
+		}
+		return landmarkIndexes;
+	}
+
+	std::vector<bool> landmarkIncluded(YERFACE_NUM_FACE_LANDMARKS, false);
+	stringstream landmarksStream(landmarksString);
+	string token;
+	while(getline(landmarksStream, token, ',')) {
+		int landmarkIndex = stoi(token);
+		if(landmarkIndex < 0 || landmarkIndex >= YERFACE_NUM_FACE_LANDMARKS) {
+			throw invalid_argument("--landmarks contains an index which is out of range.");
+		}
+		if(landmarkIncluded[landmarkIndex]) {
+			throw invalid_argument("--landmarks contains a duplicate index.");
+		}
+		landmarkIncluded[landmarkIndex] = true;
+		landmarkIndexes.push_back(landmarkIndex);
+	}
+	for(int landmarkIndex : requiredFaceLandmarkIndexes) {
+		if(!landmarkIncluded[landmarkIndex]) {
+			throw invalid_argument("--landmarks is missing landmark " + to_string(landmarkIndex) + ", which is required by FaceTracker or MarkerTracker.");
+		}
+	}
+	return landmarkIndexes;
+}
+
+dlib::full_object_detection reduceLandmarks(const dlib::full_object_detection &detection, const std::vector<int> &landmarkIndexes) {
+	std::vector<dlib::point> parts;
+	for(int landmarkIndex : landmarkIndexes) {
+		parts.push_back(detection.part(landmarkIndex));
+	}
+	return dlib::full_object_detection(detection.get_rect(), parts);
+}
+
+double getInterOcularDistance(const dlib::full_object_detection &detection, const std::vector<int> &landmarkIndexes) {
+	size_t rightEye = std::find(landmarkIndexes.begin(), landmarkIndexes.end(), IDX_RIGHTEYE_OUTER_CORNER) - landmarkIndexes.begin();
+	size_t leftEye = std::find(landmarkIndexes.begin(), landmarkIndexes.end(), IDX_LEFTEYE_OUTER_CORNER) - landmarkIndexes.begin();
+	return dlib::length(detection.part(leftEye) - detection.part(rightEye));
+}
@@ -177,6 +177,9 @@ int yerface(int argc, char *argv[]) {
 			logSeverityFilter = LOG_SEVERITY_MAX;
 		}
 		Logger::setLoggingFilter((LogMessageSeverity)logSeverityFilter);
+		if(logSeverityFilter > (int)YERFACE_LOG_SEVERITY_COMPILED_MAX) {
+			Logger::slog("Main", LOG_SEVERITY_NOTICE, "Log level filter is %s, but this build has compiled out messages more verbose than %s.", Logger::getSeverityString((LogMessageSeverity)logSeverityFilter).c_str(), Logger::getSeverityString(YERFACE_LOG_SEVERITY_COMPILED_MAX).c_str());
+		}
 	}
 	configFile = parser.get<string>("configFile");
 	inVideo = parser.get<string>("inVideo");
@@ -295,7 +298,7 @@ int yerface(int argc, char *argv[]) {
 	previewMetrics = new Metrics(config, "YerFace[Preview/Event Loop]", false);
 	frameServer = new FrameServer(config, status, lowLatency);
 	previewHUD = new PreviewHUD(config, status, frameServer, previewMirrorBool);
-	ffmpegDriver = new FFmpegDriver(status, frameServer, lowLatency, false);
+	ffmpegDriver = new FFmpegDriver(config, status, frameServer, lowLatency, false);
 	ffmpegDriver->openInputMedia(inVideo, AVMEDIA_TYPE_VIDEO, inVideoFormat, inVideoSize, "", inVideoRate, inVideoCodec, inAudioChannelMap, tryAudioInVideo);
 	if(openInputAudio) {
 		ffmpegDriver->openInputMedia(inAudio, AVMEDIA_TYPE_AUDIO, inAudioFormat, "", inAudioChannels, inAudioRate, inAudioCodec, inAudioChannelMap, true);
@@ -304,10 +307,10 @@ int yerface(int argc, char *argv[]) {
 		ffmpegDriver->openOutputMedia(outVideo);
 	}
 	sdlDriver = new SDLDriver(config, status, frameServer, ffmpegDriver, headless, previewAudio && ffmpegDriver->getIsAudioInputPresent());
-	faceDetector = new FaceDetector(config, status, frameServer);
-	faceTracker = new FaceTracker(config, status, sdlDriver, frameServer, faceDetector);
+	faceDetector = new FaceDetector(config, status, frameServer, lowLatency);
+	faceTracker = new FaceTracker(config, status, sdlDriver, frameServer, faceDetector, lowLatency);
 	faceMapper = new FaceMapper(config, status, frameServer, faceTracker, previewHUD);
-	outputDriver = new OutputDriver(config, outEventData, status, frameServer, faceTracker, sdlDriver);
+	outputDriver = new OutputDriver(config, outEventData, status, frameServer, ffmpegDriver, faceTracker, sdlDriver);
 	if(ffmpegDriver->getIsAudioInputPresent()) {
 		sphinxDriver = new SphinxDriver(config, status, frameServer, ffmpegDriver, sdlDriver, outputDriver, previewHUD, lowLatency);
 	}
@@ -441,8 +444,9 @@ int yerface(int argc, char *argv[]) {
 	YerFace_CarefullyDelete(logger, status, faceTracker);
 	YerFace_CarefullyDelete(logger, status, faceDetector);
 	YerFace_CarefullyDelete(logger, status, previewHUD);
-	YerFace_CarefullyDelete(logger, status, frameServer);
+	//FFmpegDriver deregisters from the frame server as it goes, so it must go first.
 	YerFace_CarefullyDelete(logger, status, ffmpegDriver);
+	YerFace_CarefullyDelete(logger, status, frameServer);
 	YerFace_CarefullyDelete(logger, status, sdlDriver);
 	YerFace_CarefullyDelete(logger, status, previewMetrics);
 	YerFace_CarefullyDelete(logger, status, metrics);
@@ -500,13 +504,13 @@ bool videoCaptureHandler(WorkerPoolWorker *worker) {
 	}
 
 	if(!status->getIsRunning()) {
-		logger->debug4("Issuing videoCaptureWorkerPool->stopWorkerNow()");
+		YerFace_LogDebug4(logger, "Issuing videoCaptureWorkerPool->stopWorkerNow()");
 		worker->pool->stopWorkerNow();
 		didWork = true;
 	}
 
 	if(!didWork) {
-		logger->debug4("Main Video Capture thread woke up, found no work to do, and went back to sleep.");
+		YerFace_LogDebug4(logger, "Main Video Capture thread woke up, found no work to do, and went back to sleep.");
 	}
 
 	return didWork;
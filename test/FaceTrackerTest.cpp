@@ -0,0 +1,50 @@
+#include "FaceTracker.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace YerFace;
+
+static FaceTrackerOutput makeFace(int faceId) {
+	FaceTrackerOutput output;
+	output.faceId = faceId;
+	return output;
+}
+
+static FaceTrackerFaceState makeTrackedState(void) {
+	FaceTrackerFaceState state;
+	state.previouslyReportedFacialPose.set = true;
+	state.poseSolverSeedSet = true;
+	state.landmarkFilterSet = true;
+	state.lastSeenTimestamp = 1.0;
+	return state;
+}
+
+TEST(FaceTrackerFaceState, FaceThatDisappearsAndComesBackStartsFresh) {
+	unordered_map<int, FaceTrackerFaceState> faceStates;
+	faceStates[0] = makeTrackedState();
+
+	//The face is gone, leaving only the placeholder.
+	resetAbsentFaceStates(&faceStates, { makeFace(-1) });
+	ASSERT_EQ(faceStates.count(0), 1u);
+	EXPECT_FALSE(faceStates[0].previouslyReportedFacialPose.set);
+	EXPECT_FALSE(faceStates[0].poseSolverSeedSet);
+	EXPECT_FALSE(faceStates[0].landmarkFilterSet);
+	EXPECT_EQ(faceStates[0].lastSeenTimestamp, 1.0);
+
+	//When it comes back under the same ID, there is no stale pose for its first pose to be rejected against.
+	resetAbsentFaceStates(&faceStates, { makeFace(0) });
+	EXPECT_FALSE(faceStates[0].previouslyReportedFacialPose.set);
+}
+
+TEST(FaceTrackerFaceState, PresentFacesKeepTheirHistory) {
+	unordered_map<int, FaceTrackerFaceState> faceStates;
+	faceStates[0] = makeTrackedState();
+	faceStates[1] = makeTrackedState();
+
+	resetAbsentFaceStates(&faceStates, { makeFace(1) });
+	EXPECT_FALSE(faceStates[0].previouslyReportedFacialPose.set);
+	EXPECT_TRUE(faceStates[1].previouslyReportedFacialPose.set);
+	EXPECT_TRUE(faceStates[1].poseSolverSeedSet);
+	EXPECT_TRUE(faceStates[1].landmarkFilterSet);
+}